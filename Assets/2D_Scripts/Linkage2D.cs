@@ -6,6 +6,9 @@ using UnityEditor;
 public class Linkage2D : MonoBehaviour
 {
     public GameObject linkPrefab;
+    // optional: links the DLL simulates are then drawn instanced (a bar of length 1 along x) instead of as linkPrefabs
+    public Mesh linkMesh;
+    public Material linkMaterial;
     public Joint jointToBeOptimized;
 
     private Joint[] joints;
@@ -13,6 +16,14 @@ public class Linkage2D : MonoBehaviour
     private bool isSimulationPrepared;
 
     private int dynamicEdgeCount = 0;
+    private float[] positions; // x0, y0, x1, y1, ... registered with the DLL, written by Simulate()
+    private int positionGeneration = 0;
+    private MotorDrive[] motors;
+    private int[] motorIndices;
+    private float[] motorRotations; // in radians, the start rotations sent to the DLL
+    private bool areMotorsStarted = false;
+    private Matrix4x4[] linkMatrices; // written by the DLL together with positions
+    private Matrix4x4[] linkBatch = new Matrix4x4[1023]; // most DrawMeshInstanced takes at once
     private float[] firstEnd = new float[0], secondEnd = new float[0], edgeGradient = new float[0];
 
     private void OnDrawGizmos()
@@ -52,6 +63,7 @@ public class Linkage2D : MonoBehaviour
                 j1.edges.Add(newEdge);
                 j2.edges.Add(newEdge);
                 // add prefab for visual
+                if (DrawsLinksInstanced && (IsDynamic(j1) || IsDynamic(j2))) continue;
                 Link newLink = Instantiate(linkPrefab, linkHolder.transform).GetComponent<Link>();
                 newLink.j1 = j1; newLink.j2 = j2;
             }
@@ -60,52 +72,73 @@ public class Linkage2D : MonoBehaviour
 
     private void TransferLinkageToDLL()
     {
-        DllWrapper.Init();
         // vertices
         joints = GetComponentsInChildren<Joint>();
         for (int i = 0; i < joints.Length; i++)
         {
             joints[i].index = i;
         }
-        foreach (Joint j in joints)
+        DllWrapper.VertexDesc[] verts = new DllWrapper.VertexDesc[joints.Length];
+        for (int i = 0; i < joints.Length; i++)
         {
+            Joint j = joints[i];
+            verts[i].x = j.transform.position.x;
+            verts[i].y = j.transform.position.y;
             MotorDrive motor;
             if (motor = j.GetComponent<MotorDrive>()) // motorized
             {
-                DllWrapper.AddMotorizedVertex(
-                    j.transform.position,
-                    motor.originJoint.index
-                );
+                verts[i].type = DllWrapper.VertexType.Motorized;
+                verts[i].motorVertex = motor.originJoint.index;
             }
             else if (j.isAnchored) // static
             {
-                DllWrapper.AddStaticVertex(j.transform.position);
+                verts[i].type = DllWrapper.VertexType.Static;
             }
             else // dymanic
             {
-                DllWrapper.AddDynamicVertex(j.transform.position);
+                verts[i].type = DllWrapper.VertexType.Dynamic;
             }
         }
 
         // edges
+        List<int> edgePairs = new List<int>();
         foreach (Joint j1 in joints)
         {
             foreach (Joint j2 in j1.initialEdges)
             {
-                if ((!j1.isAnchored && !j1.GetComponent<MotorDrive>())
-                    || (!j2.isAnchored && !j2.GetComponent<MotorDrive>()))
+                if (IsDynamic(j1) || IsDynamic(j2))
                 {
-                    DllWrapper.addEdge(j1.index, j2.index);
+                    edgePairs.Add(j1.index);
+                    edgePairs.Add(j2.index);
                     dynamicEdgeCount++;
                 }
             }
         }
+        if (!DllWrapper.LoadLinkage(verts, edgePairs.ToArray()))
+        {
+            Debug.LogError("DLL-ERROR: Linkage could not be loaded");
+            return;
+        }
         if (!DllWrapper.PrepareSimulation())
         {
             Debug.LogError("DLL-ERROR: Simulation could not be prepared");
         }
         else
         {
+            motors = GetComponentsInChildren<MotorDrive>();
+            motorIndices = new int[motors.Length];
+            motorRotations = new float[motors.Length];
+            for (int m = 0; m < motors.Length; m++)
+            {
+                motorIndices[m] = motors[m].GetComponent<Joint>().index;
+            }
+            positions = new float[2 * joints.Length];
+            DllWrapper.RegisterOutputBuffer(positions);
+            if (DrawsLinksInstanced)
+            {
+                linkMatrices = new Matrix4x4[dynamicEdgeCount];
+                DllWrapper.RegisterEdgeTransformBuffer(linkMatrices);
+            }
             isSimulationPrepared = true;
         }
     }
@@ -114,8 +147,9 @@ public class Linkage2D : MonoBehaviour
     {
         if (isSimulationPrepared)
         {
-            UpdateMotors();
-            UpdateJointPositions();
+            if (!areMotorsStarted) StartMotors();
+            UpdateJointPositions(DllWrapper.Step(Time.deltaTime));
+            if (linkMatrices != null) DrawLinks();
 
             if (Input.GetKeyDown(KeyCode.D))
             {
@@ -167,24 +201,51 @@ public class Linkage2D : MonoBehaviour
         }
     }
 
-    private void UpdateMotors()
+    // on the first frame, so that every MotorDrive has read its start rotation. From then on the DLL turns the motors.
+    private void StartMotors()
     {
-        foreach (MotorDrive motor in GetComponentsInChildren<MotorDrive>())
+        for (int m = 0; m < motors.Length; m++)
         {
-            DllWrapper.setMotorRotation(motor.GetComponent<Joint>().index, Mathf.Deg2Rad * motor.currentRotation);
+            motorRotations[m] = Mathf.Deg2Rad * motors[m].currentRotation;
+            DllWrapper.SetMotorDrive(motorIndices[m], motors[m].automaticRotationSpeed * 2 * Mathf.PI);
         }
+        DllWrapper.SetMotorRotations(motorIndices, motorRotations);
+        areMotorsStarted = true;
     }
 
-    private void UpdateJointPositions()
+    private void UpdateJointPositions(int generation)
     {
-        float[] xCoordinates = new float[joints.Length];
-        float[] yCoordinates = new float[joints.Length];
-        DllWrapper.getSimulatedPositions(xCoordinates, yCoordinates);
+        if (generation < 0 || generation == positionGeneration) return;
+        positionGeneration = generation;
         for (int i = 0; i < joints.Length; i++)
         {
-            joints[i].transform.position = new Vector2(xCoordinates[i], yCoordinates[i]);
+            joints[i].transform.position = new Vector2(positions[2 * i], positions[2 * i + 1]);
         }
     }
+
+    private bool DrawsLinksInstanced { get => linkMesh != null && linkMaterial != null; }
+
+    // only edges with a dynamic end are sent to the DLL
+    private static bool IsDynamic(Joint j)
+    {
+        return !j.isAnchored && !j.GetComponent<MotorDrive>();
+    }
+
+    private void DrawLinks()
+    {
+        for (int start = 0; start < linkMatrices.Length; start += linkBatch.Length)
+        {
+            int count = Mathf.Min(linkBatch.Length, linkMatrices.Length - start);
+            System.Array.Copy(linkMatrices, start, linkBatch, 0, count);
+            Graphics.DrawMeshInstanced(linkMesh, 0, linkMaterial, linkBatch, count);
+        }
+    }
+
+    private void OnDestroy()
+    {
+        if (linkMatrices != null) DllWrapper.RegisterEdgeTransformBuffer((Matrix4x4[])null);
+        if (positions != null) DllWrapper.RegisterOutputBuffer(null);
+    }
 }
 
 
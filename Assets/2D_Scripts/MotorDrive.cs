@@ -6,7 +6,7 @@ public class MotorDrive : MonoBehaviour
 {
     public Joint originJoint;
     public Vector3 axis = Vector3.forward;
-    public float currentRotation; // in degrees
+    public float currentRotation; // in degrees, the start rotation, the DLL turns the motor from there (see Linkage2D)
     public float automaticRotationSpeed; // in rotations per second
 
 
@@ -15,12 +15,6 @@ public class MotorDrive : MonoBehaviour
         currentRotation = Vector2.SignedAngle(Vector2.right, transform.position - originJoint.transform.position);
     }
 
-    private void Update()
-    {
-        currentRotation += automaticRotationSpeed * 360 * Time.deltaTime;
-        currentRotation = currentRotation % 360;
-    }
-
 
 
     private void OnDrawGizmos()
@@ -5,6 +5,17 @@ using UnityEngine;
 
 public class DllWrapper : MonoBehaviour
 {
+    public enum VertexType { Static = 0, Motorized = 1, Dynamic = 2 }
+
+    // layout must match Symbo::VertexDesc
+    [StructLayout(LayoutKind.Sequential)]
+    public struct VertexDesc
+    {
+        public float x, y;
+        public VertexType type;
+        public int motorVertex; // only read for motorized vertices
+    }
+
     // deprecated
     [DllImport("SymboDLL")]
     private static extern void symbolic_kinematic(
@@ -24,20 +35,145 @@ public class DllWrapper : MonoBehaviour
     [DllImport("SymboDLL")]
     private static extern void add_edge(int index_1, int index_2);
     [DllImport("SymboDLL")]
+    private static extern bool load_linkage(
+        [In] VertexDesc[] verts, int nv, [In] int[] edge_pairs, int ne);
+    [DllImport("SymboDLL")]
     private static extern bool prepare_simulation();
     [DllImport("SymboDLL")]
+    private static extern bool save_linkage_file(string path);
+    [DllImport("SymboDLL")]
+    private static extern bool load_linkage_file(string path);
+    [DllImport("SymboDLL")]
     private static extern void set_motor_rotation(int vertex_index, float rotation);
     [DllImport("SymboDLL")]
+    private static extern void set_motor_rotations([In] int[] vertex_indices, [In] float[] rotations, int n);
+    [DllImport("SymboDLL")]
+    private static extern void set_motor_drive(int vertex_index, float speed, [In] float[] speed_profile, int profile_size);
+    [DllImport("SymboDLL")]
+    private static extern int step(float dt);
+    [DllImport("SymboDLL")]
+    private static extern bool get_interpolated_positions(float alpha, bool resolve, [In, Out] float[] xy);
+    [DllImport("SymboDLL")]
+    private static extern void set_branch_tracking(bool enabled);
+    [DllImport("SymboDLL")]
     private static extern void get_simulated_positions(
         [In, Out] float[] x_output_array,
         [In, Out] float[] y_output_array);
     [DllImport("SymboDLL")]
+    private static extern void register_output_buffers(System.IntPtr xy, int capacity);
+    [DllImport("SymboDLL")]
+    private static extern void register_edge_output_buffer(System.IntPtr transforms, int capacity, int format);
+    [DllImport("SymboDLL")]
+    private static extern int simulate();
+    [DllImport("SymboDLL")]
+    private static extern int get_output_generation();
+    [DllImport("SymboDLL")]
+    private static extern void get_simulated_positions_with_margin(
+        [In, Out] float[] x_output_array,
+        [In, Out] float[] y_output_array,
+        [In, Out] float[] margin,
+        [In, Out] int[] valid);
+    [DllImport("SymboDLL")]
+    private static extern bool find_first_invalid_rotation(
+        float from, float to, int num_samples, out float rotation, out float min_margin);
+    [DllImport("SymboDLL")]
+    private static extern int certify_assembly(float from, float to, float resolution, out float fail_from, out float fail_to);
+    [DllImport("SymboDLL")]
+    private static extern int get_transmission_profile(float from, float to, int num_samples, int output_vertex, int input_vertex,
+        [In, Out] float[] transmission_angles, [In, Out] float[] mechanical_advantage);
+    [DllImport("SymboDLL")]
+    private static extern void set_transmission_angle_limit(float min_angle);
+    [DllImport("SymboDLL")]
+    private static extern int bake_cycle(float tolerance, int max_segments);
+    [DllImport("SymboDLL")]
+    private static extern int get_baked_cycle([In, Out] byte[] blob, int capacity);
+    [DllImport("SymboDLL")]
+    private static extern bool sample_baked_cycle([In] byte[] blob, int size, float rotation, [In, Out] float[] xy);
+    [DllImport("SymboDLL")]
+    private static extern int get_baked_cycle_error([In] byte[] blob, int size, [In, Out] float[] error);
+    [DllImport("SymboDLL")]
     private static extern void get_edge_length_gradients_for_target_position(
         int vertex_index, float x, float y,
         [In, Out] float[] first_end, [In, Out] float[] second_end, [In, Out] float[] edge_length_gradient);
     [DllImport("SymboDLL")]
     private static extern bool optimize_for_target_location(
         int vertex_index, float x, float y);
+    [DllImport("SymboDLL")]
+    private static extern bool fit_target_locations(
+        [In] int[] vertex_indices, [In] float[] target_xy, [In] float[] motor_rotations, int num_targets);
+    [DllImport("SymboDLL")]
+    private static extern int optimize_multi_start(
+        int vertex_index, float x, float y, int num_starts, float spread, int max_results,
+        [In, Out] float[] edge_length_output, [In, Out] float[] error_output);
+    [DllImport("SymboDLL")]
+    private static extern bool optimize_global_for_target_location(
+        int vertex_index, float x, float y, float step_size, int max_generations);
+    [DllImport("SymboDLL")]
+    private static extern void set_edge_lengths([In] float[] edge_lengths);
+    [DllImport("SymboDLL")]
+    private static extern int get_parameter_count();
+    [DllImport("SymboDLL")]
+    private static extern void get_parameters([In, Out] float[] parameters);
+    [DllImport("SymboDLL")]
+    private static extern void set_parameters([In] float[] parameters);
+    [DllImport("SymboDLL")]
+    private static extern int select_free_parameters([In] int[] free_index, [In] float[] scale);
+    [DllImport("SymboDLL")]
+    private static extern float get_parameter_gradients_for_target_position(
+        int vertex_index, float x, float y, [In, Out] float[] gradient);
+    [DllImport("SymboDLL")]
+    private static extern bool optimize_parameters_for_target_location(int vertex_index, float x, float y);
+    [DllImport("SymboDLL")]
+    private static extern bool drag_target_location(int vertex_index, float x, float y);
+    [DllImport("SymboDLL")]
+    private static extern void end_target_drag();
+    [DllImport("SymboDLL")]
+    private static extern int get_assembly_mode([In, Out] int[] mirrored);
+    [DllImport("SymboDLL")]
+    private static extern void set_assembly_mode([In] int[] mirrored);
+    [DllImport("SymboDLL")]
+    private static extern bool optimize_assembly_mode_for_target_location(
+        int vertex_index, float x, float y, out float distance);
+    [DllImport("SymboDLL")]
+    private static extern bool start_simulation_thread(float steps_per_second);
+    [DllImport("SymboDLL")]
+    private static extern void stop_simulation_thread();
+    [DllImport("SymboDLL")]
+    private static extern bool is_simulation_thread_running();
+    [DllImport("SymboDLL")]
+    private static extern System.IntPtr acquire_latest_frame(out int generation);
+    [DllImport("SymboDLL")]
+    private static extern bool post_motor_rotation(int vertex_index, float rotation);
+    [DllImport("SymboDLL")]
+    private static extern bool post_motor_speed(int vertex_index, float speed);
+    [DllImport("SymboDLL")]
+    private static extern int create_instances(int count);
+    [DllImport("SymboDLL")]
+    private static extern void set_instance_states(int first, int count, [In] float[] rotations, [In] float[] speeds, [In] float[] transforms);
+    [DllImport("SymboDLL")]
+    private static extern int get_instance_output_size(int format);
+    [DllImport("SymboDLL")]
+    private static extern bool step_instances(float dt, [In, Out] float[] output, int format);
+    [DllImport("SymboDLL")]
+    private static extern bool step_instances(float dt, [In, Out] Matrix4x4[] output, int format);
+    [DllImport("SymboDLL")]
+    private static extern void destroy_instances();
+    [DllImport("SymboDLL")]
+    private static extern int get_design_size();
+    [DllImport("SymboDLL")]
+    private static extern void set_anchor_positions([In] float[] xy);
+    [DllImport("SymboDLL")]
+    private static extern bool start_design_exploration(
+        int foot_vertex, int num_samples, int population_size, float edge_spread, float anchor_spread);
+    [DllImport("SymboDLL")]
+    private static extern void stop_design_exploration();
+    [DllImport("SymboDLL")]
+    private static extern bool optimize_cycle_objectives(
+        int foot_vertex, int num_samples, [In] float[] weights, float step_size, int max_generations,
+        bool use_surrogate, out int true_evaluations, out int saved_evaluations);
+    [DllImport("SymboDLL")]
+    private static extern int get_pareto_front(
+        [In, Out] float[] designs, [In, Out] float[] objectives, int max_designs, out int generation);
 
 
     /// <summary>
@@ -79,21 +215,220 @@ public class DllWrapper : MonoBehaviour
         add_edge(index1, index2);
     }
 
+    /// <summary>
+    /// Replaces the linkage in one call: vertex v gets index v, edge e connects edgePairs[2e] and edgePairs[2e + 1].
+    /// Returns false (and leaves an empty linkage) if a type or index is invalid.
+    /// </summary>
+    public static bool LoadLinkage(VertexDesc[] verts, int[] edgePairs)
+    {
+        return load_linkage(verts, verts.Length, edgePairs, edgePairs.Length / 2);
+    }
+
     public static bool PrepareSimulation()
     {
         return prepare_simulation();
     }
 
+    /// <summary>
+    /// Writes the prepared linkage, including optimized lengths, assembly mode and motor phases, to a binary file.
+    /// </summary>
+    public static bool SaveLinkageFile(string path)
+    {
+        return save_linkage_file(path);
+    }
+
+    /// <summary>
+    /// Replaces the linkage by a file from SaveLinkageFile. It is ready to simulate, PrepareSimulation is not needed.
+    /// </summary>
+    public static bool LoadLinkageFile(string path)
+    {
+        return load_linkage_file(path);
+    }
+
     public static void setMotorRotation(int vertexIndex, float rotation)
     {
         set_motor_rotation(vertexIndex, rotation);
     }
 
+    /// <summary>
+    /// Sets all given motors (rotations in radians) in one call. vertexIndices = null means one rotation per motor, in the order they were added.
+    /// </summary>
+    public static void SetMotorRotations(int[] vertexIndices, float[] rotations)
+    {
+        set_motor_rotations(vertexIndices, rotations, vertexIndices != null ? vertexIndices.Length : rotations.Length);
+    }
+
+    /// <summary>
+    /// Lets the DLL turn the motor: speed in radians per second, speedProfile (may be null) multiplies the speed
+    /// at evenly spaced rotations over one turn. The motor's phase offset is a parameter, see SetParameters.
+    /// </summary>
+    public static void SetMotorDrive(int vertexIndex, float speed, float[] speedProfile = null)
+    {
+        set_motor_drive(vertexIndex, speed, speedProfile, speedProfile != null ? speedProfile.Length : 0);
+    }
+
+    /// <summary>
+    /// Advances all motors by dt seconds and simulates into the registered buffer, returns the generation like Simulate.
+    /// Returns -1 without advancing if no large enough buffer is registered.
+    /// </summary>
+    public static int Step(float dt)
+    {
+        return step(dt);
+    }
+
+    /// <summary>
+    /// Positions (x0, y0, x1, y1, ...) alpha of the way between the last two Steps, for rendering between fixed steps.
+    /// resolve solves the linkage at the interpolated motor rotations, which keeps every link length exact.
+    /// </summary>
+    public static bool GetInterpolatedPositions(float alpha, bool resolve, float[] xy)
+    {
+        return get_interpolated_positions(alpha, resolve, xy);
+    }
+
+    /// <summary>
+    /// Dyads continue through stretched positions onto the other branch instead of snapping back,
+    /// and positions stay finite.
+    /// </summary>
+    public static void setBranchTracking(bool enabled)
+    {
+        set_branch_tracking(enabled);
+    }
+
     public static void getSimulatedPositions(float[] x_output_array, float[] y_output_array)
     {
         get_simulated_positions(x_output_array, y_output_array);
     }
 
+    private static GCHandle outputHandle;
+
+    /// <summary>
+    /// Pins xy (x0, y0, x1, y1, ...) and lets Simulate write into it directly. Pass null to release it.
+    /// </summary>
+    public static void RegisterOutputBuffer(float[] xy)
+    {
+        register_output_buffers(System.IntPtr.Zero, 0);
+        if (outputHandle.IsAllocated) outputHandle.Free();
+        if (xy == null) return;
+        outputHandle = GCHandle.Alloc(xy, GCHandleType.Pinned);
+        register_output_buffers(outputHandle.AddrOfPinnedObject(), xy.Length / 2);
+    }
+
+    private static GCHandle edgeOutputHandle;
+
+    /// <summary>
+    /// Pins matrices and lets Simulate / Step write one transform per DLL edge into it, mapping a bar of length 1 along x
+    /// onto the link, ready for Graphics.DrawMeshInstanced. Pass null to release it.
+    /// </summary>
+    public static void RegisterEdgeTransformBuffer(Matrix4x4[] matrices)
+    {
+        RegisterEdgeOutput(matrices, matrices != null ? matrices.Length : 0, 1);
+    }
+
+    /// <summary>
+    /// Same with 4 floats per edge: midpoint x, y and the vector from the first to the second vertex.
+    /// </summary>
+    public static void RegisterEdgeTransformBuffer(float[] transforms)
+    {
+        RegisterEdgeOutput(transforms, transforms != null ? transforms.Length / 4 : 0, 0);
+    }
+
+    private static void RegisterEdgeOutput(object buffer, int capacity, int format)
+    {
+        register_edge_output_buffer(System.IntPtr.Zero, 0, 0);
+        if (edgeOutputHandle.IsAllocated) edgeOutputHandle.Free();
+        if (buffer == null) return;
+        edgeOutputHandle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
+        register_edge_output_buffer(edgeOutputHandle.AddrOfPinnedObject(), capacity, format);
+    }
+
+    /// <summary>
+    /// Simulates into the registered buffer and returns the generation of the new frame, -1 if the buffer is missing or too small.
+    /// </summary>
+    public static int Simulate()
+    {
+        return simulate();
+    }
+
+    public static int GetOutputGeneration()
+    {
+        return get_output_generation();
+    }
+
+    /// <summary>
+    /// Positions plus, per joint, the margin to singularity (0 = a dyad is flat, negative = does not assemble)
+    /// and whether it is valid (margin >= 0). margin or valid may be null.
+    /// </summary>
+    public static void getSimulatedPositionsWithMargin(float[] x_output_array, float[] y_output_array, float[] margin, int[] valid)
+    {
+        get_simulated_positions_with_margin(x_output_array, y_output_array, margin, valid);
+    }
+
+    /// <summary>
+    /// Sweeps numSamples motor rotations from `from` to `to` in one batch. Returns true and the first rotation
+    /// at which the linkage does not assemble, false if it assembles everywhere.
+    /// </summary>
+    public static bool FindFirstInvalidRotation(float from, float to, int numSamples, out float rotation, out float minMargin)
+    {
+        return find_first_invalid_rotation(from, to, numSamples, out rotation, out minMargin);
+    }
+
+    /// <summary>
+    /// Interval arithmetic proof that the linkage assembles for every rotation in [from, to]: 1 = proven,
+    /// 0 = certainly fails on [failFrom, failTo], -1 = undecided around [failFrom, failTo] at this resolution.
+    /// </summary>
+    public static int CertifyAssembly(float from, float to, float resolution, out float failFrom, out float failTo)
+    {
+        return certify_assembly(from, to, resolution, out failFrom, out failTo);
+    }
+
+    /// <summary>
+    /// Transmission angle of every dynamic vertex (numSamples * dynamic vertex count, sample-major, may be null) and the
+    /// mechanical advantage, output speed over input speed (numSamples, may be null), over one sweep. Returns the dynamic
+    /// vertex count, -1 if a vertex index is out of range.
+    /// </summary>
+    public static int GetTransmissionProfile(float from, float to, int numSamples, int outputVertex, int inputVertex,
+        float[] transmissionAngles, float[] mechanicalAdvantage)
+    {
+        return get_transmission_profile(from, to, numSamples, outputVertex, inputVertex, transmissionAngles, mechanicalAdvantage);
+    }
+
+    /// <summary>
+    /// Samples with a transmission angle outside [minAngle, pi - minAngle] count as violations in the optimizers. 0 disables it.
+    /// </summary>
+    public static void SetTransmissionAngleLimit(float minAngle)
+    {
+        set_transmission_angle_limit(minAngle);
+    }
+
+    /// <summary>
+    /// Fits every joint's path over one motor turn with splines until their estimated error (sampled, not a bound) is
+    /// within tolerance, and returns them as a serializable blob for SampleBakedCycle. Null if the linkage cannot be baked.
+    /// </summary>
+    public static byte[] BakeCycle(float tolerance, int maxSegments = 4096)
+    {
+        int size = bake_cycle(tolerance, maxSegments);
+        if (size == 0) return null;
+        byte[] blob = new byte[size];
+        get_baked_cycle(blob, size);
+        return blob;
+    }
+
+    /// <summary>
+    /// Joint positions (x0, y0, x1, y1, ...) at the given motor rotation (radians) from a baked blob, without simulating.
+    /// </summary>
+    public static bool SampleBakedCycle(byte[] blob, float rotation, float[] xy)
+    {
+        return sample_baked_cycle(blob, blob.Length, rotation, xy);
+    }
+
+    /// <summary>
+    /// Per-joint estimated error of a baked blob. Returns its number of spline segments, -1 if the blob is malformed.
+    /// </summary>
+    public static int GetBakedCycleError(byte[] blob, float[] error)
+    {
+        return get_baked_cycle_error(blob, blob.Length, error);
+    }
+
     public static void GetEdgeLengthGradientsForTargetPosition(int vertexIndex, Vector2 targetPos,
         float[] firstEnd, float[] secondEnd, float[] edgeLengthGradient)
     {
@@ -106,6 +441,287 @@ public class DllWrapper : MonoBehaviour
         return optimize_for_target_location(vertex_index, target.x, target.y);
     }
 
+    /// <summary>
+    /// Least-squares fit of all edge lengths, so that each vertex reaches its target at the given motor rotation (in radians).
+    /// </summary>
+    public static bool FitTargetLocations(int[] vertexIndices, Vector2[] targets, float[] motorRotations)
+    {
+        float[] targetXY = new float[2 * targets.Length];
+        for (int i = 0; i < targets.Length; i++)
+        {
+            targetXY[2 * i] = targets[i].x;
+            targetXY[2 * i + 1] = targets[i].y;
+        }
+        return fit_target_locations(vertexIndices, targetXY, motorRotations, targets.Length);
+    }
+
+    /// <summary>
+    /// Optimizes from several perturbed starts in parallel. Returns the distinct designs (edge lengths), best first.
+    /// </summary>
+    public static List<float[]> OptimizeMultiStart(int vertexIndex, Vector2 target, int edgeCount,
+        int numStarts, float spread, int maxResults, out float[] errors)
+    {
+        float[] edgeLengths = new float[maxResults * edgeCount];
+        float[] allErrors = new float[maxResults];
+        int found = optimize_multi_start(vertexIndex, target.x, target.y, numStarts, spread, maxResults, edgeLengths, allErrors);
+
+        List<float[]> designs = new List<float[]>();
+        errors = new float[found];
+        for (int r = 0; r < found; r++)
+        {
+            float[] design = new float[edgeCount];
+            System.Array.Copy(edgeLengths, r * edgeCount, design, 0, edgeCount);
+            designs.Add(design);
+            errors[r] = allErrors[r];
+        }
+        return designs;
+    }
+
+    /// <summary>
+    /// Gradient-free global search (CMA-ES) over all edge lengths. Returns false if no better design was found.
+    /// </summary>
+    public static bool OptimizeGlobalForTargetLocation(int vertexIndex, Vector2 target, float stepSize, int maxGenerations)
+    {
+        return optimize_global_for_target_location(vertexIndex, target.x, target.y, stepSize, maxGenerations);
+    }
+
+    public static void SetEdgeLengths(float[] edgeLengths)
+    {
+        set_edge_lengths(edgeLengths);
+    }
+
+    /// <summary>
+    /// All linkage parameters: edge lengths, anchor positions (x, y per static vertex),
+    /// motor radii and motor phase offsets (radians).
+    /// </summary>
+    public static float[] GetParameters()
+    {
+        float[] parameters = new float[get_parameter_count()];
+        get_parameters(parameters);
+        return parameters;
+    }
+
+    public static void SetParameters(float[] parameters)
+    {
+        set_parameters(parameters);
+    }
+
+    /// <summary>
+    /// Chooses what OptimizeParametersForTargetLocation may change: parameter p follows variable
+    /// freeIndex[p] (-1 = fixed), multiplied by scale[p]. Parameters sharing a variable are tied.
+    /// Pass null to restore the default (all active edges and motor radii). Returns the number of variables.
+    /// </summary>
+    public static int SelectFreeParameters(int[] freeIndex, float[] scale = null)
+    {
+        return select_free_parameters(freeIndex, scale);
+    }
+
+    /// <summary>
+    /// Gradient of the target distance for every variable of the current selection. Returns the distance.
+    /// </summary>
+    public static float GetParameterGradientsForTargetPosition(int vertexIndex, Vector2 target, float[] gradient)
+    {
+        return get_parameter_gradients_for_target_position(vertexIndex, target.x, target.y, gradient);
+    }
+
+    public static bool OptimizeParametersForTargetLocation(int vertexIndex, Vector2 target)
+    {
+        return optimize_parameters_for_target_location(vertexIndex, target.x, target.y);
+    }
+
+    /// <summary>
+    /// Call every frame while the target is dragged: the previous solution is carried along with the target
+    /// instead of optimizing from scratch. Call EndTargetDrag() when the target is released.
+    /// </summary>
+    public static bool DragTargetLocation(int vertexIndex, Vector2 target)
+    {
+        return drag_target_location(vertexIndex, target.x, target.y);
+    }
+
+    public static void EndTargetDrag()
+    {
+        end_target_drag();
+    }
+
+    /// <summary>
+    /// One flag per dynamic joint (in the order they were added): 0 = the side it was placed on, 1 = mirrored.
+    /// </summary>
+    public static int GetAssemblyMode(int[] mirrored)
+    {
+        return get_assembly_mode(mirrored);
+    }
+
+    public static void SetAssemblyMode(int[] mirrored)
+    {
+        set_assembly_mode(mirrored);
+    }
+
+    /// <summary>
+    /// Switches to the assembly mode that brings the vertex closest to the target at the current motor rotations.
+    /// </summary>
+    public static bool OptimizeAssemblyModeForTargetLocation(int vertexIndex, Vector2 target, out float distance)
+    {
+        return optimize_assembly_mode_for_target_location(vertexIndex, target.x, target.y, out distance);
+    }
+
+    /// <summary>
+    /// Number of floats per design: all edge lengths, followed by x and y of every static vertex.
+    /// </summary>
+    public static int GetDesignSize()
+    {
+        return get_design_size();
+    }
+
+    public static void SetAnchorPositions(Vector2[] anchors)
+    {
+        set_anchor_positions(Vector2ArrayToArray(anchors));
+    }
+
+    /// <summary>
+    /// Starts a multi-objective search (NSGA-II) in the background. Poll GetParetoFront while it runs,
+    /// and call StopDesignExploration before modifying the linkage.
+    /// </summary>
+    public static bool StartDesignExploration(int footVertex, int numSamples, int populationSize,
+        float edgeSpread, float anchorSpread)
+    {
+        return start_design_exploration(footVertex, numSamples, populationSize, edgeSpread, anchorSpread);
+    }
+
+    public static void StopDesignExploration()
+    {
+        stop_design_exploration();
+    }
+
+    /// <summary>
+    /// Single-objective search on the weighted cycle objectives (stride, flatness, peak velocity, transmission angle).
+    /// With useSurrogate, only promising candidates are simulated; savedEvaluations tells how many were skipped.
+    /// </summary>
+    public static bool OptimizeCycleObjectives(int footVertex, int numSamples, float[] weights, float stepSize,
+        int maxGenerations, bool useSurrogate, out int trueEvaluations, out int savedEvaluations)
+    {
+        return optimize_cycle_objectives(footVertex, numSamples, weights, stepSize, maxGenerations,
+            useSurrogate, out trueEvaluations, out savedEvaluations);
+    }
+
+    /// <summary>
+    /// Latest non-dominated designs. objectives holds 4 floats per design:
+    /// stride length, foot path flatness, peak joint velocity, minimum transmission angle (radians).
+    /// </summary>
+    public static List<float[]> GetParetoFront(int maxDesigns, out float[] objectives, out int generation)
+    {
+        int designSize = get_design_size();
+        float[] allDesigns = new float[maxDesigns * designSize];
+        float[] allObjectives = new float[maxDesigns * 4];
+        int found = get_pareto_front(allDesigns, allObjectives, maxDesigns, out generation);
+
+        List<float[]> designs = new List<float[]>();
+        for (int d = 0; d < found; d++)
+        {
+            float[] design = new float[designSize];
+            System.Array.Copy(allDesigns, d * designSize, design, 0, designSize);
+            designs.Add(design);
+        }
+        objectives = new float[found * 4];
+        System.Array.Copy(allObjectives, objectives, found * 4);
+        return designs;
+    }
+
+    /// <summary>
+    /// Simulates on a thread of the DLL at a fixed rate, steer it with PostMotorRotation / PostMotorSpeed. Any other
+    /// call that reads or changes the linkage or the motors stops it first, see IsSimulationThreadRunning.
+    /// </summary>
+    public static bool StartSimulationThread(float stepsPerSecond)
+    {
+        return start_simulation_thread(stepsPerSecond);
+    }
+
+    public static void StopSimulationThread()
+    {
+        stop_simulation_thread();
+    }
+
+    /// <summary>
+    /// False once StopSimulationThread or any call that touches the linkage stopped the simulation thread.
+    /// </summary>
+    public static bool IsSimulationThreadRunning()
+    {
+        return is_simulation_thread_running();
+    }
+
+    /// <summary>
+    /// Copies the newest frame of the simulation thread into xy (x0, y0, x1, y1, ...) without waiting.
+    /// Returns its generation, 0 (and leaves xy as it is) if there is no frame yet.
+    /// </summary>
+    public static int AcquireLatestFrame(float[] xy)
+    {
+        int generation;
+        System.IntPtr frame = acquire_latest_frame(out generation);
+        if (frame == System.IntPtr.Zero) return 0;
+        Marshal.Copy(frame, xy, 0, xy.Length);
+        return generation;
+    }
+
+    public static bool PostMotorRotation(int vertexIndex, float rotation)
+    {
+        return post_motor_rotation(vertexIndex, rotation);
+    }
+
+    public static bool PostMotorSpeed(int vertexIndex, float speed)
+    {
+        return post_motor_speed(vertexIndex, speed);
+    }
+
+    /// <summary>
+    /// Copies the current linkage count times for crowds of identical mechanisms, all advanced together by StepInstances.
+    /// Lengths, anchors and sizes are copied, the rest is read live: create them again after editing the linkage.
+    /// Returns count, 0 if the linkage cannot be instanced (it has loop closures).
+    /// </summary>
+    public static int CreateInstances(int count)
+    {
+        return create_instances(count);
+    }
+
+    /// <summary>
+    /// Crank angle, speed (radians per second) and transform (x, y, angle, scale, 4 floats each) of instances
+    /// first, first + 1, ... Pass null to keep an attribute as it is.
+    /// </summary>
+    public static void SetInstanceStates(int first, int count, float[] rotations, float[] speeds, float[] transforms)
+    {
+        set_instance_states(first, count, rotations, speeds, transforms);
+    }
+
+    /// <summary>
+    /// Floats per instance written by StepInstances: format 0 joints (x, y), 1 edges (midpoint x, y, link vector x, y),
+    /// 2 edges as 4x4 matrices.
+    /// </summary>
+    public static int GetInstanceOutputSize(int format)
+    {
+        return get_instance_output_size(format);
+    }
+
+    /// <summary>
+    /// Advances all instances by dt and writes them in world space, instance after instance, into output
+    /// (GetInstanceOutputSize(format) floats each, null to only advance). False without writing if the linkage
+    /// gained or lost vertices, edges, anchors or motors since CreateInstances.
+    /// </summary>
+    public static bool StepInstances(float dt, float[] output, int format)
+    {
+        return step_instances(dt, output, format);
+    }
+
+    /// <summary>
+    /// As StepInstances with format 2: one matrix per edge and instance, ready for Graphics.DrawMeshInstanced.
+    /// </summary>
+    public static bool StepInstances(float dt, Matrix4x4[] edgeMatrices)
+    {
+        return step_instances(dt, edgeMatrices, 2);
+    }
+
+    public static void DestroyInstances()
+    {
+        destroy_instances();
+    }
+
     // helpers
 
     private static Vector2 ArrayToVec2(float[] arr)
@@ -117,4 +733,15 @@ public class DllWrapper : MonoBehaviour
     {
         return new float[] { vec.x, vec.y };
     }
+
+    private static float[] Vector2ArrayToArray(Vector2[] vecs)
+    {
+        float[] arr = new float[2 * vecs.Length];
+        for (int i = 0; i < vecs.Length; i++)
+        {
+            arr[2 * i] = vecs[i].x;
+            arr[2 * i + 1] = vecs[i].y;
+        }
+        return arr;
+    }
 }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+namespace Symbo {
+
+	// Baked motor cycle: every vertex's path over one turn of the motors as a periodic piecewise cubic in the
+	// rotation, num_segments uniform segments. Stored as one little-endian blob, evaluated in place:
+	//
+	//   BakedCycleHeader
+	//   float error[num_vertices]                                   estimated error, sampled at test angles
+	//   float coefficients[num_segments][num_vertices][8]           ax, bx, cx, dx, ay, by, cy, dy
+	//
+	// Within a segment, x(t) = ((ax * t + bx) * t + cx) * t + dx for t in [0, 1), y likewise. Any layout
+	// change must bump the version.
+	static const char baked_cycle_magic[4] = { 'S', 'Y', 'B', 'C' };
+	static const uint32_t baked_cycle_version = 1;
+
+	struct BakedCycleHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t num_vertices;
+		uint32_t num_segments;
+	};
+
+	static_assert(sizeof(BakedCycleHeader) == 16, "baked cycle header layout");
+
+	inline size_t baked_cycle_size(uint32_t num_vertices, uint32_t num_segments) {
+		return sizeof(BakedCycleHeader) + num_vertices * sizeof(float) + (size_t)num_segments * num_vertices * 8 * sizeof(float);
+	}
+
+	// the header of a well-formed blob of the given size, nullptr otherwise
+	inline const BakedCycleHeader* baked_cycle_header(const void* blob, size_t size) {
+		if (blob == nullptr || size < sizeof(BakedCycleHeader)) return nullptr;
+		const BakedCycleHeader* header = static_cast<const BakedCycleHeader*>(blob);
+		if (!equal(begin(baked_cycle_magic), end(baked_cycle_magic), header->magic) || header->version != baked_cycle_version
+			|| header->num_segments == 0 || baked_cycle_size(header->num_vertices, header->num_segments) != size) {
+			return nullptr;
+		}
+		return header;
+	}
+
+	inline const float* baked_cycle_error(const BakedCycleHeader* header) {
+		return reinterpret_cast<const float*>(header + 1);
+	}
+
+	inline const float* baked_cycle_coefficients(const BakedCycleHeader* header) {
+		return baked_cycle_error(header) + header->num_vertices;
+	}
+
+	// positions at the given rotation (any real number, one turn is 2 pi), interleaved into xy
+	inline void evaluate_baked_cycle(const BakedCycleHeader* header, float rotation, float* xy) {
+		const int num_vertices = header->num_vertices, num_segments = header->num_segments;
+		const float turns = rotation / (2 * 3.14159265358979323846f);
+		const float s = (turns - floor(turns)) * num_segments;
+		const int segment = min((int)s, num_segments - 1);
+		const float t = s - segment;
+		const float* c = baked_cycle_coefficients(header) + (size_t)segment * num_vertices * 8;
+		for (int v = 0; v < num_vertices; v++, c += 8) {
+			xy[2 * v] = ((c[0] * t + c[1]) * t + c[2]) * t + c[3];
+			xy[2 * v + 1] = ((c[4] * t + c[5]) * t + c[6]) * t + c[7];
+		}
+	}
+
+}
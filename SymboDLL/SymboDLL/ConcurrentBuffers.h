@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+using namespace std;
+
+namespace Symbo {
+
+	// Fixed-capacity queue between exactly one producer thread and one consumer thread. Neither side
+	// ever waits: push fails when the queue is full, pop when it is empty.
+	template<typename T, size_t Capacity>
+	class SpscQueue {
+	public:
+		bool push(const T& item) {
+			size_t tail_now = tail.load(memory_order_relaxed);
+			if (tail_now - head.load(memory_order_acquire) == Capacity) return false;
+			items[tail_now % Capacity] = item;
+			tail.store(tail_now + 1, memory_order_release); // publishes the item
+			return true;
+		}
+
+		bool pop(T& item) {
+			size_t head_now = head.load(memory_order_relaxed);
+			if (head_now == tail.load(memory_order_acquire)) return false;
+			item = items[head_now % Capacity];
+			head.store(head_now + 1, memory_order_release); // frees the slot
+			return true;
+		}
+
+		// only while neither side is using the queue
+		void clear() {
+			head.store(0);
+			tail.store(0);
+		}
+
+	private:
+		T items[Capacity];
+		atomic<size_t> head{ 0 }, tail{ 0 }; // free running, only their difference matters
+	};
+
+	// Hands the newest complete value from one writer thread to one reader thread without locks. The writer
+	// fills back() and publishes it, the reader acquires the latest published value into front(). Each side
+	// owns one of the three buffers at any time, the third is in the middle, so neither ever waits for the other.
+	template<typename T>
+	class TripleBuffer {
+	public:
+		T& back() { return buffers[back_index]; }
+		void publish() {
+			back_index = middle.exchange(back_index | fresh_bit, memory_order_acq_rel) & index_mask;
+		}
+
+		// returns false (and keeps front()) if nothing was published since the last acquire
+		bool acquire() {
+			if (!(middle.load(memory_order_acquire) & fresh_bit)) return false;
+			front_index = middle.exchange(front_index, memory_order_acq_rel) & index_mask;
+			return true;
+		}
+		const T& front() const { return buffers[front_index]; }
+
+		// only while neither side is using the buffer, e.g. to size all three
+		T& buffer(int i) { return buffers[i]; }
+		void reset() {
+			back_index = 0;
+			front_index = 1;
+			middle.store(2);
+		}
+
+	private:
+		static const int fresh_bit = 4, index_mask = 3;
+		T buffers[3];
+		int back_index = 0, front_index = 1; // owned by the writer / the reader
+		atomic<int> middle{ 2 }; // index of the third buffer, plus fresh_bit if the writer published it
+	};
+
+}
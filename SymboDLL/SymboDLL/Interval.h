@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+using namespace std;
+
+namespace Symbo {
+
+	// own namespace, so that cos, sqrt, ... below are only found for intervals (by argument dependent lookup)
+	// and do not hide the standard ones for plain numbers
+	namespace IntervalArithmetic {
+
+	// Closed interval [lo, hi] of real numbers. Every operation returns an interval that contains all
+	// possible results, rounded outwards by one ulp on each side so that floating point rounding cannot
+	// make it too narrow. An empty interval (lo > hi) stands for "no value".
+	struct Interval {
+		double lo, hi;
+
+		Interval() : lo(0), hi(0) {}
+		Interval(double value) : lo(value), hi(value) {}
+		Interval(double lo, double hi) : lo(lo), hi(hi) {}
+
+		static Interval empty() { return Interval(numeric_limits<double>::infinity(), -numeric_limits<double>::infinity()); }
+
+		bool is_empty() const { return !(lo <= hi); }
+		double width() const { return hi - lo; }
+		double mid() const { return 0.5 * (lo + hi); }
+		bool contains(double value) const { return lo <= value && value <= hi; }
+		// every value of this is in other
+		bool inside(const Interval& other) const { return other.lo <= lo && hi <= other.hi; }
+	};
+
+	inline Interval outward(double lo, double hi) {
+		return Interval(nextafter(lo, -numeric_limits<double>::infinity()), nextafter(hi, numeric_limits<double>::infinity()));
+	}
+
+	inline Interval intersect(const Interval& a, const Interval& b) {
+		return Interval(max(a.lo, b.lo), min(a.hi, b.hi));
+	}
+
+	inline Interval operator+(const Interval& a, const Interval& b) { return outward(a.lo + b.lo, a.hi + b.hi); }
+	inline Interval operator-(const Interval& a, const Interval& b) { return outward(a.lo - b.hi, a.hi - b.lo); }
+	inline Interval operator-(const Interval& a) { return Interval(-a.hi, -a.lo); }
+
+	inline Interval operator*(const Interval& a, const Interval& b) {
+		double p1 = a.lo * b.lo, p2 = a.lo * b.hi, p3 = a.hi * b.lo, p4 = a.hi * b.hi;
+		return outward(min(min(p1, p2), min(p3, p4)), max(max(p1, p2), max(p3, p4)));
+	}
+
+	// whole real line if b contains 0
+	inline Interval operator/(const Interval& a, const Interval& b) {
+		if (b.contains(0)) return Interval(-numeric_limits<double>::infinity(), numeric_limits<double>::infinity());
+		return a * outward(1 / b.hi, 1 / b.lo);
+	}
+
+	// a * a, which unlike the product is never negative
+	inline Interval square(const Interval& a) {
+		double l = a.lo * a.lo, h = a.hi * a.hi;
+		if (a.contains(0)) return Interval(0, nextafter(max(l, h), numeric_limits<double>::infinity()));
+		return outward(min(l, h), max(l, h));
+	}
+
+	// of the non-negative part
+	inline Interval sqrt(const Interval& a) {
+		return outward(std::sqrt(max(0.0, a.lo)), std::sqrt(max(0.0, a.hi)));
+	}
+
+	inline Interval abs(const Interval& a) {
+		if (a.contains(0)) return Interval(0, max(-a.lo, a.hi));
+		return a.lo > 0 ? a : -a;
+	}
+
+	inline Interval cos(const Interval& a) {
+		const double two_pi = 2 * 3.14159265358979323846;
+		if (a.width() >= two_pi) return Interval(-1, 1);
+		// shift so that lo is in [0, 2pi), then hi < 4pi: the minima are at pi and 3pi, the maximum at 2pi
+		double shift = floor(a.lo / two_pi) * two_pi;
+		double lo = a.lo - shift, hi = a.hi - shift;
+		double c_lo = std::cos(lo), c_hi = std::cos(hi);
+		double result_lo = min(c_lo, c_hi), result_hi = max(c_lo, c_hi);
+		if ((lo <= 0.5 * two_pi && 0.5 * two_pi <= hi) || 1.5 * two_pi <= hi) result_lo = -1;
+		if (two_pi <= hi) result_hi = 1;
+		return Interval(max(-1.0, nextafter(result_lo, -2.0)), min(1.0, nextafter(result_hi, 2.0)));
+	}
+
+	inline Interval sin(const Interval& a) {
+		return cos(a - Interval(0.5 * 3.14159265358979323846));
+	}
+
+	}
+	using IntervalArithmetic::Interval;
+
+}
@@ -0,0 +1,52 @@
+#include "pch.h" // use stdafx.h in Visual Studio 2017 and earlier
+#include "LinkageFile.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace Symbo {
+
+#ifdef _WIN32
+	MappedFile::MappedFile(const char* path) {
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return;
+		file_handle = file;
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return;
+		mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle == nullptr) return;
+		data = static_cast<const unsigned char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+		if (data != nullptr) size = file_size.QuadPart;
+	}
+
+	MappedFile::~MappedFile() {
+		if (data != nullptr) UnmapViewOfFile(data);
+		if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+		if (file_handle != nullptr) CloseHandle(file_handle);
+	}
+#else
+	MappedFile::MappedFile(const char* path) {
+		int file = open(path, O_RDONLY);
+		if (file < 0) return;
+		struct stat info;
+		if (fstat(file, &info) == 0 && info.st_size > 0) {
+			void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapped != MAP_FAILED) {
+				data = static_cast<const unsigned char*>(mapped);
+				size = info.st_size;
+			}
+		}
+		close(file); // the mapping stays valid
+	}
+
+	MappedFile::~MappedFile() {
+		if (data != nullptr) munmap(const_cast<unsigned char*>(data), size);
+	}
+#endif
+
+}
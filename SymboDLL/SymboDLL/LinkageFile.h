@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "SymboDLL.h"
+#include "Linkage_Data.h"
+using namespace std;
+
+namespace Symbo {
+
+	// Binary linkage file: a header followed by flat little-endian arrays of 4-byte fields, so that a mapped
+	// file can be read in place. Next to the vertices and edges it holds the motor bindings and the plan
+	// prepare_simulation() compiled (dyad order, dependants, assembly mode, current lengths), so loading
+	// skips the dependency analysis. Any layout change must bump the version.
+	//
+	//   LinkageFileHeader
+	//   VertexDesc        vertices[num_vertices]
+	//   int32             edge_pairs[2 * num_edges]
+	//   LinkageFileMotor  motors[num_motors]
+	//   LinkageFileDyad   dyads[num_dyads]              in order of dependence
+	//   LoopClosureLink   loop_links[num_loop_links]
+	static const char linkage_file_magic[4] = { 'S', 'Y', 'L', 'K' };
+	static const uint32_t linkage_file_version = 1;
+
+	struct LinkageFileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t file_size; // in bytes, guards against truncated files
+		uint32_t num_vertices, num_edges, num_motors, num_dyads, num_loop_links;
+		// byte offsets of the arrays from the start of the file
+		uint32_t vertex_offset, edge_offset, motor_offset, dyad_offset, loop_link_offset;
+	};
+
+	struct LinkageFileMotor {
+		int32_t vertex;
+		int32_t edge_to_motor;
+		float distance_to_motor;
+		float phase_offset;
+		float current_rotation;
+	};
+
+	struct LinkageFileDyad {
+		int32_t vertex;
+		int32_t dependant_i, dependant_j;
+		int32_t edge_to_i, edge_to_j;
+		int32_t mirrored;
+		float distance_to_i, distance_to_j;
+	};
+
+	static_assert(sizeof(LinkageFileHeader) == 52, "linkage file header layout");
+	static_assert(sizeof(VertexDesc) == 16, "linkage file vertex layout");
+	static_assert(sizeof(LinkageFileMotor) == 20, "linkage file motor layout");
+	static_assert(sizeof(LinkageFileDyad) == 32, "linkage file dyad layout");
+	static_assert(sizeof(LoopClosureLink) == 16, "linkage file loop link layout");
+
+	// read-only memory map of a whole file, unmapped on destruction
+	class MappedFile {
+	public:
+		explicit MappedFile(const char* path);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool is_open() const { return data != nullptr; }
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+
+	private:
+		void* file_handle = nullptr;
+		void* mapping_handle = nullptr;
+	};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 using namespace std;
 
 namespace Symbo {
@@ -30,12 +31,20 @@ namespace Symbo {
 		int motor_vertex;
 		float distance_to_motor;
 		float current_rotation;
+		float phase_offset; // added to current_rotation, lets several motors run out of phase
+		int edge_to_motor; // index into the edge list, -1 if the crank has no explicit edge
+		float speed; // radians per second, advanced by step()
+		// multiplies speed, sampled evenly over one turn of current_rotation (periodic, linearly interpolated). empty = constant
+		vector<float> speed_profile;
 		MotorizedVertex(float x, float y, int motor_vertex, float distance_to_motor, int index) {
 			this->initial_x = x;
 			this->initial_y = y;
 			this->motor_vertex = motor_vertex;
 			this->distance_to_motor = distance_to_motor;
 			this->current_rotation = 0;
+			this->phase_offset = 0;
+			this->edge_to_motor = -1;
+			this->speed = 0;
 			this->index = index;
 			this->type = VertexType::MOTORIZED;
 		}
@@ -45,6 +54,8 @@ namespace Symbo {
 	public:
 		int dependant_i, dependant_j;
 		float distance_to_i, distance_to_j;
+		int edge_to_i, edge_to_j; // indices into the edge list
+		bool mirrored; // assembly mode: placed on the other side of i-j than in the initial layout
 		DynamicVertex(float x, float y, int index) {
 			this->initial_x = x;
 			this->initial_y = y;
@@ -55,7 +66,24 @@ namespace Symbo {
 			this->dependant_j = -1;
 			this->distance_to_i = 0;
 			this->distance_to_j = 0;
+			this->edge_to_i = -1;
+			this->edge_to_j = -1;
+			this->mirrored = false;
 		}
+
+		// i -> j -> k always runs counter-clockwise, so exchanging i and j switches to the other side
+		void swap_dependants() {
+			swap(dependant_i, dependant_j);
+			swap(distance_to_i, distance_to_j);
+			swap(edge_to_i, edge_to_j);
+		}
+	};
+
+	// an edge that constrains at least one vertex the dyads cannot place (see prepare_simulation())
+	struct LoopClosureLink {
+		int vertex_a, vertex_b;
+		int edge; // index into the edge list
+		float length;
 	};
 
 }
@@ -0,0 +1,211 @@
+#include "pch.h" // use stdafx.h in Visual Studio 2017 and earlier
+#include <algorithm>
+#include <limits>
+#include "Nsga2.h"
+
+using namespace std;
+using namespace Eigen;
+
+namespace Symbo {
+
+	Nsga2::Nsga2(int num_objectives, Evaluator evaluate)
+		: num_objectives(num_objectives), evaluate(evaluate), gen((random_device())()) {}
+
+	void Nsga2::initialize(const VectorXd& seed) {
+		const int num_genes = lower_bound.size();
+		uniform_real_distribution<double> uniform(0, 1);
+		population.resize(num_genes, population_size);
+		for (int c = 0; c < population_size; c++) {
+			for (int g = 0; g < num_genes; g++) {
+				population(g, c) = lower_bound(g) + uniform(gen) * (upper_bound(g) - lower_bound(g));
+			}
+		}
+		population.col(0) = seed.cwiseMax(lower_bound).cwiseMin(upper_bound);
+		evaluate(population, objectives, violation);
+
+		rank.assign(population_size, 0);
+		crowding.assign(population_size, 0);
+		int r = 0;
+		for (const vector<int>& front : non_dominated_sort(objectives, violation)) {
+			vector<double> distance;
+			crowding_distance(objectives, front, distance);
+			for (int f = 0; f < front.size(); f++) {
+				rank[front[f]] = r;
+				crowding[front[f]] = distance[f];
+			}
+			r++;
+		}
+		generation = 0;
+	}
+
+	void Nsga2::step() {
+		const int num_genes = population.rows();
+
+		// offspring
+		Population offspring(num_genes, population_size);
+		for (int c = 0; c < population_size; c += 2) {
+			VectorXd child_1 = population.col(tournament());
+			VectorXd child_2 = population.col(tournament());
+			crossover(child_1, child_2);
+			mutate(child_1);
+			mutate(child_2);
+			offspring.col(c) = child_1;
+			if (c + 1 < population_size) offspring.col(c + 1) = child_2;
+		}
+		Objectives offspring_objectives;
+		VectorXd offspring_violation;
+		evaluate(offspring, offspring_objectives, offspring_violation);
+
+		// parents and offspring compete for the next generation
+		Population combined(num_genes, 2 * population_size);
+		combined << population, offspring;
+		Objectives combined_objectives(num_objectives, 2 * population_size);
+		combined_objectives << objectives, offspring_objectives;
+		VectorXd combined_violation(2 * population_size);
+		combined_violation << violation, offspring_violation;
+
+		vector<int> selected;
+		vector<int> selected_rank;
+		vector<double> selected_crowding;
+		int r = 0;
+		for (const vector<int>& front : non_dominated_sort(combined_objectives, combined_violation)) {
+			vector<double> distance;
+			crowding_distance(combined_objectives, front, distance);
+			vector<int> order(front.size());
+			for (int f = 0; f < front.size(); f++) order[f] = f;
+			if (selected.size() + front.size() > population_size) {
+				// last front only partially fits, prefer the less crowded members
+				sort(order.begin(), order.end(), [&](int a, int b) { return distance[a] > distance[b]; });
+			}
+			for (int f : order) {
+				if (selected.size() == population_size) break;
+				selected.push_back(front[f]);
+				selected_rank.push_back(r);
+				selected_crowding.push_back(distance[f]);
+			}
+			if (selected.size() == population_size) break;
+			r++;
+		}
+
+		for (int c = 0; c < population_size; c++) {
+			population.col(c) = combined.col(selected[c]);
+			objectives.col(c) = combined_objectives.col(selected[c]);
+			violation(c) = combined_violation(selected[c]);
+		}
+		rank = selected_rank;
+		crowding = selected_crowding;
+		generation++;
+	}
+
+	void Nsga2::get_front(Population& designs, Objectives& front_objectives) const {
+		vector<int> front;
+		for (int c = 0; c < population_size; c++) {
+			if (rank[c] == 0 && violation(c) == 0) front.push_back(c);
+		}
+		designs.resize(population.rows(), front.size());
+		front_objectives.resize(num_objectives, front.size());
+		for (int f = 0; f < front.size(); f++) {
+			designs.col(f) = population.col(front[f]);
+			front_objectives.col(f) = objectives.col(front[f]);
+		}
+	}
+
+	// constraint domination: feasible beats infeasible, less violation beats more, otherwise Pareto dominance
+	bool Nsga2::dominates(const Objectives& obj, const VectorXd& viol, int a, int b) const {
+		if (viol(a) > 0 || viol(b) > 0) return viol(a) < viol(b);
+		bool strictly_better = false;
+		for (int o = 0; o < num_objectives; o++) {
+			if (obj(o, a) > obj(o, b)) return false;
+			if (obj(o, a) < obj(o, b)) strictly_better = true;
+		}
+		return strictly_better;
+	}
+
+	// fast non-dominated sort, returns the fronts in order
+	vector<vector<int>> Nsga2::non_dominated_sort(const Objectives& obj, const VectorXd& viol) const {
+		const int n = obj.cols();
+		vector<vector<int>> dominated_by(n);
+		vector<int> domination_count(n, 0);
+		vector<vector<int>> fronts(1);
+		for (int a = 0; a < n; a++) {
+			for (int b = a + 1; b < n; b++) {
+				if (dominates(obj, viol, a, b)) {
+					dominated_by[a].push_back(b);
+					domination_count[b]++;
+				} else if (dominates(obj, viol, b, a)) {
+					dominated_by[b].push_back(a);
+					domination_count[a]++;
+				}
+			}
+		}
+		for (int a = 0; a < n; a++) {
+			if (domination_count[a] == 0) fronts[0].push_back(a);
+		}
+		while (!fronts.back().empty()) {
+			vector<int> next;
+			for (int a : fronts.back()) {
+				for (int b : dominated_by[a]) {
+					if (--domination_count[b] == 0) next.push_back(b);
+				}
+			}
+			fronts.push_back(next);
+		}
+		fronts.pop_back();
+		return fronts;
+	}
+
+	void Nsga2::crowding_distance(const Objectives& obj, const vector<int>& front, vector<double>& distance) const {
+		const double infinity = numeric_limits<double>::infinity();
+		distance.assign(front.size(), 0);
+		vector<int> order(front.size());
+		for (int o = 0; o < num_objectives; o++) {
+			for (int f = 0; f < front.size(); f++) order[f] = f;
+			sort(order.begin(), order.end(), [&](int a, int b) { return obj(o, front[a]) < obj(o, front[b]); });
+			const double range = obj(o, front[order.back()]) - obj(o, front[order.front()]);
+			distance[order.front()] = distance[order.back()] = infinity;
+			if (!(range > 0)) continue;
+			for (int f = 1; f + 1 < order.size(); f++) {
+				distance[order[f]] += (obj(o, front[order[f + 1]]) - obj(o, front[order[f - 1]])) / range;
+			}
+		}
+	}
+
+	// binary tournament on rank, then crowding
+	int Nsga2::tournament() {
+		uniform_int_distribution<int> pick(0, population_size - 1);
+		int a = pick(gen), b = pick(gen);
+		if (rank[a] != rank[b]) return rank[a] < rank[b] ? a : b;
+		return crowding[a] >= crowding[b] ? a : b;
+	}
+
+	// simulated binary crossover
+	void Nsga2::crossover(VectorXd& child_1, VectorXd& child_2) {
+		uniform_real_distribution<double> uniform(0, 1);
+		if (uniform(gen) > crossover_probability) return;
+		for (int g = 0; g < child_1.size(); g++) {
+			if (uniform(gen) > 0.5 || abs(child_1(g) - child_2(g)) < 1e-14) continue;
+			const double u = uniform(gen);
+			const double beta = u <= 0.5
+				? pow(2 * u, 1 / (crossover_eta + 1))
+				: pow(1 / (2 * (1 - u)), 1 / (crossover_eta + 1));
+			const double x_1 = child_1(g), x_2 = child_2(g);
+			child_1(g) = min(max(0.5 * ((1 + beta) * x_1 + (1 - beta) * x_2), lower_bound(g)), upper_bound(g));
+			child_2(g) = min(max(0.5 * ((1 - beta) * x_1 + (1 + beta) * x_2), lower_bound(g)), upper_bound(g));
+		}
+	}
+
+	// polynomial mutation, one gene per child on average
+	void Nsga2::mutate(VectorXd& child) {
+		uniform_real_distribution<double> uniform(0, 1);
+		const double probability = 1.0 / child.size();
+		for (int g = 0; g < child.size(); g++) {
+			if (uniform(gen) > probability) continue;
+			const double u = uniform(gen);
+			const double delta = u < 0.5
+				? pow(2 * u, 1 / (mutation_eta + 1)) - 1
+				: 1 - pow(2 * (1 - u), 1 / (mutation_eta + 1));
+			child(g) = min(max(child(g) + delta * (upper_bound(g) - lower_bound(g)), lower_bound(g)), upper_bound(g));
+		}
+	}
+
+}
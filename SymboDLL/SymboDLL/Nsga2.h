@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <functional>
+#include <Eigen/Core>
+using namespace std;
+
+namespace Symbo {
+
+	// Multi-objective genetic algorithm NSGA-II (Deb et al. 2002), with constraint domination,
+	// SBX crossover and polynomial mutation. All objectives are minimized.
+	// Candidates are the columns of a genes x population matrix, so every generation is handed to
+	// the evaluator as one batch.
+	class Nsga2 {
+	public:
+		using Population = Eigen::MatrixXd; // genes x candidates
+		using Objectives = Eigen::MatrixXd; // objectives x candidates
+		// fills objectives and constraint violation (0 = feasible) for every candidate
+		using Evaluator = function<void(const Population&, Objectives&, Eigen::VectorXd&)>;
+
+		Eigen::VectorXd lower_bound, upper_bound;
+		int population_size = 100;
+		double crossover_probability = 0.9;
+		double crossover_eta = 15, mutation_eta = 20; // distribution indices, larger = children closer to parents
+		int generation = 0;
+
+		Nsga2(int num_objectives, Evaluator evaluate);
+
+		// random population within the bounds, seed is always part of it
+		void initialize(const Eigen::VectorXd& seed);
+		// one generation: select, recombine, mutate, evaluate and keep the best population_size candidates
+		void step();
+		// feasible, non-dominated members of the current population
+		void get_front(Population& designs, Objectives& front_objectives) const;
+
+	private:
+		int num_objectives;
+		Evaluator evaluate;
+		mt19937 gen;
+
+		Population population;
+		Objectives objectives;
+		Eigen::VectorXd violation;
+		vector<int> rank;
+		vector<double> crowding;
+
+		bool dominates(const Objectives& obj, const Eigen::VectorXd& viol, int a, int b) const;
+		vector<vector<int>> non_dominated_sort(const Objectives& obj, const Eigen::VectorXd& viol) const;
+		void crowding_distance(const Objectives& obj, const vector<int>& front, vector<double>& distance) const;
+		int tournament();
+		void crossover(Eigen::VectorXd& child_1, Eigen::VectorXd& child_2);
+		void mutate(Eigen::VectorXd& child);
+	};
+
+}
@@ -3,13 +3,29 @@
 #include <limits.h>
 #include "SymboDLL.h"
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <mutex>
+#include <chrono>
+#include <limits>
+#include <tuple>
 using namespace std;
 
 #include "Linkage_Data.h"
+#include "Nsga2.h"
+#include "Interval.h"
+#include "LinkageFile.h"
+#include "ConcurrentBuffers.h"
+#include "BakedCycle.h"
+#include "WorkerPool.h"
 
 // Eigen
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <Eigen/Eigenvalues>
+#include <Eigen/SparseCore>
+#include <Eigen/SparseLU>
 using namespace Eigen;
 
 // cppoptlib
@@ -17,6 +33,12 @@ using namespace Eigen;
 #include <cppoptlib/problem.h>
 #include <cppoptlib/solver/bfgssolver.h>
 #include <cppoptlib/solver/gradientdescentsolver.h>
+#include <cppoptlib/solver/lbfgssolver.h>
+#include <cppoptlib/solver/cmaessolver.h>
+#include <cppoptlib/solver/levenbergmarquardtsolver.h>
+#include <cppoptlib/solver/trustregionnewtoncgsolver.h>
+#include <cppoptlib/linesearch/batchedwolfe.h>
+#include <cppoptlib/surrogateproblem.h>
 using namespace cppoptlib;
 
 // autodiff
@@ -40,10 +62,75 @@ namespace Symbo {
 	static int num_vertices = false;
 	static bool is_initialized;
 
+	// Dynamic vertices that cannot be placed dyad by dyad (triads, Stephenson chains, ...) are solved together
+	// from the loop-closure constraints of their edges, see solve_loop_closure().
+	static vector<int> loop_closure_verts;
+	static vector<int> loop_closure_slot; // per vertex: its position in loop_closure_verts, -1 if placed by a dyad
+	static vector<LoopClosureLink> loop_closure_links;
+	static VectorXd loop_closure_positions; // x0, y0, x1, y1, ... of the last solution, the next one starts there
+	static int loop_closure_iterations = 0; // Newton iterations the last solve took
+
+	// Branch tracking: instead of the fixed side from prepare_simulation(), every dyad takes the side that
+	// continues the motion of the previous frames (see get_simulated_positions()).
+	static bool branch_tracking = false;
+	static vector<Vector2f> tracked_positions, tracked_velocities; // per vertex, of the last frame
+	static int tracked_frames = 0;
+
+	// Caller-owned output of simulate(): x0, y0, x1, y1, ... for up to output_capacity vertices. The generation
+	// counts the frames written into it, so a reader can tell a fresh frame from one it has already seen.
+	static float* output_xy = nullptr;
+	static int output_capacity = 0;
+	static atomic<int> output_generation(0);
+	static vector<float> frame_x, frame_y; // simulate() works in these, so it does not allocate per frame
+	// optional per-edge output next to the positions, see register_edge_output_buffer()
+	static float* edge_output = nullptr;
+	static int edge_output_capacity = 0;
+	static int edge_output_format = 0; // 0 = midpoint, angle, length; 1 = 4x4 matrix
+
+	// The last two states step() reached, get_interpolated_positions() renders in between.
+	struct SteppedState {
+		vector<float> x, y;
+		vector<float> speeds; // per motor
+	};
+	static SteppedState stepped_states[2]; // earlier, latest
+	static int num_stepped_states = 0;
+	static float stepped_dt = 0;
+	static vector<float> stepped_advances; // per motor, how far it turned in the last step (not wrapped around)
+
+	// Which linkage parameters (see parameter_count()) optimizations may change. Parameter p follows
+	// optimization variable free_parameter_index[p] (-1 = fixed), multiplied by free_parameter_scale[p].
+	// Parameters following the same variable are tied, e.g. the two legs of a mirrored linkage.
+	// Empty = default selection, see get_free_parameter_selection().
+	static vector<int> free_parameter_index;
+	static vector<float> free_parameter_scale;
+
+
+	// one worker per core besides the calling thread, started on first use. Never destroyed: joining threads
+	// while the DLL is being unloaded can deadlock the loader, and idle workers only wait on a condition variable.
+	static WorkerPool& worker_pool() {
+		static WorkerPool* pool = new WorkerPool(max(1u, thread::hardware_concurrency()) - 1);
+		return *pool;
+	}
+
+	// runs body(i) for every i in [0, count) on all cores, handing out indices one at a time.
+	// body may only read the linkage state above.
+	template<typename Body>
+	void parallel_for(int count, const Body& body) {
+		if (count <= 1 || worker_pool().num_workers() == 0) { // not worth waking a worker
+			for (int i = 0; i < count; i++) body(i);
+			return;
+		}
+		worker_pool().run(count, body);
+	}
+
 
 	// --- data preparation ---
 
 	void init() {
+		stop_simulation_thread(); // first, its branch tracking may stop the exploration as well
+		stop_design_exploration(); // it reads the linkage that is about to be cleared
+		end_target_drag();
+		destroy_instances(); // they are copies of the linkage about to be cleared
 		if (is_initialized) { // memory management
 			all_verts.clear();
 			static_verts.clear();
@@ -51,7 +138,15 @@ namespace Symbo {
 			dynamic_verts.clear();
 			ordered_dymanic_indices.clear();
 			edges.clear();
+			free_parameter_index.clear();
+			free_parameter_scale.clear();
+			loop_closure_verts.clear();
+			loop_closure_slot.clear();
+			loop_closure_links.clear();
 		}
+		set_branch_tracking(false);
+		set_transmission_angle_limit(0);
+		num_stepped_states = 0;
 
 		all_verts = vector<Vertex*>();
 		static_verts = list<StaticVertex>();
@@ -64,6 +159,8 @@ namespace Symbo {
 	}
 
 	int add_static_vertex(float x, float y) {
+		stop_simulation_thread();
+		stop_design_exploration();
 		int new_index = num_vertices++;
 		StaticVertex new_vert = StaticVertex(x, y, new_index);
 		static_verts.push_back(new_vert);
@@ -72,6 +169,8 @@ namespace Symbo {
 	}
 
 	int add_motorized_vertex(float x, float y, int motor_vertex) {
+		stop_simulation_thread();
+		stop_design_exploration();
 		int new_index = num_vertices++;
 		float distance_to_motor = (Vector2f(all_verts[motor_vertex]->initial_x, all_verts[motor_vertex]->initial_y)
 			- Vector2f(x, y)).norm();
@@ -82,6 +181,8 @@ namespace Symbo {
 	}
 
 	int add_dynamic_vertex(float x, float y) {
+		stop_simulation_thread();
+		stop_design_exploration();
 		int new_index = num_vertices++;
 		DynamicVertex new_vert = DynamicVertex(x, y, new_index);
 		dynamic_verts.push_back(new_vert);
@@ -90,12 +191,114 @@ namespace Symbo {
 	}
 
 	void add_edge(int index_1, int index_2) {
+		stop_simulation_thread();
+		stop_design_exploration();
 		all_verts[index_1]->edges.push_back(index_2);
 		all_verts[index_2]->edges.push_back(index_1);
 		edges.push_back(pair<int, int>(index_1, index_2));
 	}
 
+	bool load_linkage(const VertexDesc* verts, int nv, const int* edge_pairs, int ne) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		init();
+		if (nv < 0 || ne < 0 || (nv > 0 && verts == nullptr) || (ne > 0 && edge_pairs == nullptr)) return false;
+		// validate everything first, so that a bad description leaves an empty linkage instead of half of one
+		vector<int> degree(nv, 0);
+		for (int v = 0; v < nv; v++) {
+			const VertexDesc& desc = verts[v];
+			if (desc.type == (int)VertexType::MOTORIZED) {
+				if (desc.motor_vertex < 0 || desc.motor_vertex >= nv || desc.motor_vertex == v) return false;
+			}
+			else if (desc.type != (int)VertexType::STATIC && desc.type != (int)VertexType::DYNAMIC) {
+				return false;
+			}
+		}
+		for (int e = 0; e < ne; e++) {
+			int a = edge_pairs[2 * e], b = edge_pairs[2 * e + 1];
+			if (a < 0 || a >= nv || b < 0 || b >= nv || a == b) return false;
+			degree[a]++;
+			degree[b]++;
+		}
+
+		all_verts.reserve(nv);
+		edges.reserve(ne);
+		for (int v = 0; v < nv; v++) {
+			const VertexDesc& desc = verts[v];
+			Vertex* vert;
+			if (desc.type == (int)VertexType::STATIC) {
+				static_verts.emplace_back(desc.x, desc.y, v);
+				vert = &static_verts.back();
+			}
+			else if (desc.type == (int)VertexType::MOTORIZED) {
+				const VertexDesc& motor = verts[desc.motor_vertex];
+				float distance_to_motor = (Vector2f(motor.x, motor.y) - Vector2f(desc.x, desc.y)).norm();
+				motorized_verts.emplace_back(desc.x, desc.y, desc.motor_vertex, distance_to_motor, v);
+				vert = &motorized_verts.back();
+			}
+			else {
+				dynamic_verts.emplace_back(desc.x, desc.y, v);
+				vert = &dynamic_verts.back();
+			}
+			vert->edges.reserve(degree[v]);
+			all_verts.push_back(vert);
+		}
+		num_vertices = nv;
+		for (int e = 0; e < ne; e++) {
+			add_edge(edge_pairs[2 * e], edge_pairs[2 * e + 1]);
+		}
+		return true;
+	}
+
+	// returns the index of the edge between the two vertices, or -1 if they are not connected
+	static int find_edge(int index_1, int index_2) {
+		for (int e = 0; e < edges.size(); e++) {
+			if ((edges[e].first == index_1 && edges[e].second == index_2)
+				|| (edges[e].first == index_2 && edges[e].second == index_1)) {
+				return e;
+			}
+		}
+		return -1;
+	}
+
+	// Collects the dynamic vertices that no dyad reaches and every edge that constrains them. Their layout
+	// is the first solution. Fails if the constraints cannot determine them (fewer constraints than coordinates).
+	static bool prepare_loop_closure() {
+		loop_closure_verts.clear();
+		loop_closure_links.clear();
+		loop_closure_slot.assign(num_vertices, -1);
+		vector<bool> placed_by_dyad(num_vertices, false);
+		for (int index_k : ordered_dymanic_indices) {
+			placed_by_dyad[index_k] = true;
+		}
+		for (const DynamicVertex& d_vert : dynamic_verts) {
+			if (!placed_by_dyad[d_vert.index]) {
+				loop_closure_slot[d_vert.index] = loop_closure_verts.size();
+				loop_closure_verts.push_back(d_vert.index);
+			}
+		}
+		loop_closure_positions.resize(2 * loop_closure_verts.size());
+		for (int v = 0; v < loop_closure_verts.size(); v++) {
+			loop_closure_positions(2 * v) = all_verts[loop_closure_verts[v]]->initial_x;
+			loop_closure_positions(2 * v + 1) = all_verts[loop_closure_verts[v]]->initial_y;
+		}
+		for (int e = 0; e < edges.size(); e++) {
+			if (loop_closure_slot[edges[e].first] < 0 && loop_closure_slot[edges[e].second] < 0) continue;
+			Vector2f a(all_verts[edges[e].first]->initial_x, all_verts[edges[e].first]->initial_y);
+			Vector2f b(all_verts[edges[e].second]->initial_x, all_verts[edges[e].second]->initial_y);
+			loop_closure_links.push_back({ edges[e].first, edges[e].second, e, (a - b).norm() });
+		}
+		return loop_closure_links.size() >= loop_closure_positions.size();
+	}
+
 	bool prepare_simulation() {
+		stop_simulation_thread();
+		stop_design_exploration();
+		set_branch_tracking(branch_tracking); // restarts the history for the new vertex count
+		for (MotorizedVertex& m_vert : motorized_verts) {
+			m_vert.edge_to_motor = find_edge(m_vert.index, m_vert.motor_vertex);
+		}
+
 		// order dynamic vertices by dependence
 		
 		int sorted = 0;
@@ -139,19 +342,16 @@ namespace Symbo {
 			Vector2f k_to_j = dependant_j - k;
 			dyn->distance_to_i = k_to_i.norm();
 			dyn->distance_to_j = k_to_j.norm();
+			dyn->edge_to_i = find_edge(dyn->index, dyn->dependant_i);
+			dyn->edge_to_j = find_edge(dyn->index, dyn->dependant_j);
 
 			// i -> j -> k must traverse the triangle counter-clockwise to ensure the correct orientation.
 			// therefore, switch if triangle-normal is wrong.
 
 			if (Vector3f(k_to_i.x(), k_to_i.y(), 0).cross(Vector3f(k_to_j.x(), k_to_j.y(), 0)).z() < 0) {
-				int tempindex = dyn->dependant_i;
-				dyn->dependant_i = dyn->dependant_j;
-				dyn->dependant_j = tempindex;
-
-				float tempdist = dyn->distance_to_i;
-				dyn->distance_to_i = dyn->distance_to_j;
-				dyn->distance_to_j = tempdist;
+				dyn->swap_dependants();
 			}
+			dyn->mirrored = false;
 
 			sorted++;
 			for (int adj : all_verts[current]->edges) {
@@ -163,283 +363,2035 @@ namespace Symbo {
 				}
 			}
 		}
-		if (sorted < dynamic_verts.size()) {
-			return false; // did not manage to fit all
+		// vertices that no dyad reaches (if any) are solved together
+		return prepare_loop_closure();
+	}
+
+	bool save_linkage_file(const char* path) {
+		stop_simulation_thread();
+		LinkageFileHeader header;
+		copy(begin(linkage_file_magic), end(linkage_file_magic), header.magic);
+		header.version = linkage_file_version;
+		header.num_vertices = num_vertices;
+		header.num_edges = edges.size();
+		header.num_motors = motorized_verts.size();
+		header.num_dyads = ordered_dymanic_indices.size();
+		header.num_loop_links = loop_closure_links.size();
+		header.vertex_offset = sizeof(LinkageFileHeader);
+		header.edge_offset = header.vertex_offset + header.num_vertices * sizeof(VertexDesc);
+		header.motor_offset = header.edge_offset + header.num_edges * 2 * sizeof(int32_t);
+		header.dyad_offset = header.motor_offset + header.num_motors * sizeof(LinkageFileMotor);
+		header.loop_link_offset = header.dyad_offset + header.num_dyads * sizeof(LinkageFileDyad);
+		header.file_size = header.loop_link_offset + header.num_loop_links * sizeof(LoopClosureLink);
+
+		vector<VertexDesc> vertices(num_vertices);
+		for (int v = 0; v < num_vertices; v++) {
+			const Vertex* vert = all_verts[v];
+			vertices[v] = { vert->initial_x, vert->initial_y, (int)vert->type,
+				vert->type == VertexType::MOTORIZED ? static_cast<const MotorizedVertex*>(vert)->motor_vertex : -1 };
+		}
+		vector<int32_t> edge_pairs;
+		edge_pairs.reserve(2 * edges.size());
+		for (const pair<int, int>& edge : edges) {
+			edge_pairs.push_back(edge.first);
+			edge_pairs.push_back(edge.second);
+		}
+		vector<LinkageFileMotor> motors;
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			motors.push_back({ m_vert.index, m_vert.edge_to_motor, m_vert.distance_to_motor, m_vert.phase_offset, m_vert.current_rotation });
+		}
+		vector<LinkageFileDyad> dyads;
+		for (int index_k : ordered_dymanic_indices) {
+			const DynamicVertex& d_vert = *static_cast<const DynamicVertex*>(all_verts[index_k]);
+			dyads.push_back({ index_k, d_vert.dependant_i, d_vert.dependant_j, d_vert.edge_to_i, d_vert.edge_to_j,
+				d_vert.mirrored ? 1 : 0, d_vert.distance_to_i, d_vert.distance_to_j });
+		}
+
+		ofstream file(path, ios::binary | ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(VertexDesc));
+		file.write(reinterpret_cast<const char*>(edge_pairs.data()), edge_pairs.size() * sizeof(int32_t));
+		file.write(reinterpret_cast<const char*>(motors.data()), motors.size() * sizeof(LinkageFileMotor));
+		file.write(reinterpret_cast<const char*>(dyads.data()), dyads.size() * sizeof(LinkageFileDyad));
+		file.write(reinterpret_cast<const char*>(loop_closure_links.data()), loop_closure_links.size() * sizeof(LoopClosureLink));
+		return file.good();
+	}
+
+	// The mapped arrays are read in place but not kept: load_linkage() copies the vertices and edges, the stored
+	// motors and dyads are checked and copied over the plan, and the loop-closure links are collected again by
+	// prepare_loop_closure() (a linear pass), with only their lengths taken from the file after matching edges.
+	bool load_linkage_file(const char* path) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		const uint32_t byte_order_probe = 1;
+		if (*reinterpret_cast<const unsigned char*>(&byte_order_probe) != 1) return false; // big-endian host
+
+		MappedFile file(path);
+		if (!file.is_open() || file.size < sizeof(LinkageFileHeader)) return false;
+		const LinkageFileHeader& header = *reinterpret_cast<const LinkageFileHeader*>(file.data);
+		if (!equal(begin(linkage_file_magic), end(linkage_file_magic), header.magic)
+			|| header.version != linkage_file_version || header.file_size != file.size) {
+			return false;
+		}
+		auto section_fits = [&](uint32_t offset, uint64_t count, size_t element_size) {
+			return offset % 4 == 0 && offset + count * element_size <= file.size;
+		};
+		if (!section_fits(header.vertex_offset, header.num_vertices, sizeof(VertexDesc))
+			|| !section_fits(header.edge_offset, header.num_edges, 2 * sizeof(int32_t))
+			|| !section_fits(header.motor_offset, header.num_motors, sizeof(LinkageFileMotor))
+			|| !section_fits(header.dyad_offset, header.num_dyads, sizeof(LinkageFileDyad))
+			|| !section_fits(header.loop_link_offset, header.num_loop_links, sizeof(LoopClosureLink))) {
+			return false;
+		}
+		const VertexDesc* vertices = reinterpret_cast<const VertexDesc*>(file.data + header.vertex_offset);
+		const int32_t* edge_pairs = reinterpret_cast<const int32_t*>(file.data + header.edge_offset);
+		const LinkageFileMotor* motors = reinterpret_cast<const LinkageFileMotor*>(file.data + header.motor_offset);
+		const LinkageFileDyad* dyads = reinterpret_cast<const LinkageFileDyad*>(file.data + header.dyad_offset);
+		const LoopClosureLink* loop_links = reinterpret_cast<const LoopClosureLink*>(file.data + header.loop_link_offset);
+
+		if (!load_linkage(vertices, header.num_vertices, edge_pairs, header.num_edges)) return false;
+
+		const int num_edges = edges.size();
+		auto is_edge = [&](int e) { return e >= -1 && e < num_edges; };
+		auto is_vertex = [&](int v, VertexType type) { return v >= 0 && v < num_vertices && all_verts[v]->type == type; };
+		auto is_known = [&](int v, const vector<bool>& placed) { return v >= 0 && v < num_vertices && placed[v]; };
+		bool valid = header.num_motors == motorized_verts.size();
+		for (uint32_t m = 0; valid && m < header.num_motors; m++) {
+			const LinkageFileMotor& motor = motors[m];
+			valid = is_vertex(motor.vertex, VertexType::MOTORIZED) && is_edge(motor.edge_to_motor);
+			if (!valid) break;
+			MotorizedVertex& m_vert = *static_cast<MotorizedVertex*>(all_verts[motor.vertex]);
+			m_vert.edge_to_motor = motor.edge_to_motor;
+			m_vert.distance_to_motor = motor.distance_to_motor;
+			m_vert.phase_offset = motor.phase_offset;
+			m_vert.current_rotation = motor.current_rotation;
+		}
+		// a dyad may only depend on vertices placed before it, like in prepare_simulation()
+		vector<bool> placed(num_vertices, false);
+		for (const Vertex* vert : all_verts) {
+			placed[vert->index] = vert->type != VertexType::DYNAMIC;
+		}
+		ordered_dymanic_indices.reserve(header.num_dyads);
+		for (uint32_t d = 0; valid && d < header.num_dyads; d++) {
+			const LinkageFileDyad& dyad = dyads[d];
+			valid = is_vertex(dyad.vertex, VertexType::DYNAMIC) && !placed[dyad.vertex]
+				&& is_known(dyad.dependant_i, placed) && is_known(dyad.dependant_j, placed)
+				&& is_edge(dyad.edge_to_i) && is_edge(dyad.edge_to_j);
+			if (!valid) break;
+			DynamicVertex& d_vert = *static_cast<DynamicVertex*>(all_verts[dyad.vertex]);
+			d_vert.dependant_i = dyad.dependant_i;
+			d_vert.dependant_j = dyad.dependant_j;
+			d_vert.edge_to_i = dyad.edge_to_i;
+			d_vert.edge_to_j = dyad.edge_to_j;
+			d_vert.distance_to_i = dyad.distance_to_i;
+			d_vert.distance_to_j = dyad.distance_to_j;
+			d_vert.mirrored = dyad.mirrored != 0;
+			placed[dyad.vertex] = true;
+			ordered_dymanic_indices.push_back(dyad.vertex);
+		}
+		valid = valid && prepare_loop_closure() && loop_closure_links.size() == header.num_loop_links;
+		for (uint32_t l = 0; valid && l < header.num_loop_links; l++) {
+			valid = loop_links[l].edge == loop_closure_links[l].edge;
+			loop_closure_links[l].length = loop_links[l].length;
+		}
+		if (!valid) {
+			init();
+			return false;
 		}
+		set_branch_tracking(branch_tracking); // restarts the history for the new vertex count
 		return true;
 	}
 
 
 	// --- control ---
 
+	// all_verts already maps indices to vertices, so no search through motorized_verts is needed
+	static MotorizedVertex* find_motor(int vertex_index) {
+		if (vertex_index < 0 || vertex_index >= num_vertices || all_verts[vertex_index]->type != VertexType::MOTORIZED) {
+			return nullptr;
+		}
+		return static_cast<MotorizedVertex*>(all_verts[vertex_index]);
+	}
+
 	void set_motor_rotation(int vertex_index, float rotation) {
-		for (auto it = motorized_verts.begin(); it != motorized_verts.end(); it++) {
-			if (it->index == vertex_index) {
-				it->current_rotation = rotation;
-				return;
+		stop_simulation_thread();
+		MotorizedVertex* m_vert = find_motor(vertex_index);
+		if (m_vert != nullptr) m_vert->current_rotation = rotation;
+	}
+
+	void set_motor_rotations(const int* vertex_indices, const float* rotations, int n) {
+		stop_simulation_thread();
+		if (vertex_indices == nullptr) {
+			auto it = motorized_verts.begin();
+			for (int m = 0; m < n && it != motorized_verts.end(); m++, it++) {
+				it->current_rotation = rotations[m];
+			}
+			return;
+		}
+		for (int m = 0; m < n; m++) {
+			set_motor_rotation(vertex_indices[m], rotations[m]);
+		}
+	}
+
+
+	void set_motor_drive(int vertex_index, float speed, const float* speed_profile, int profile_size) {
+		stop_simulation_thread();
+		MotorizedVertex* m_vert = find_motor(vertex_index);
+		if (m_vert == nullptr) return;
+		m_vert->speed = speed;
+		if (speed_profile != nullptr && profile_size > 0) {
+			m_vert->speed_profile.assign(speed_profile, speed_profile + profile_size);
+		} else {
+			m_vert->speed_profile.clear();
+		}
+	}
+
+	// angular speed of a motor at the given rotation
+	static float motor_speed(const MotorizedVertex& m_vert, float rotation) {
+		const vector<float>& profile = m_vert.speed_profile;
+		if (profile.empty()) return m_vert.speed;
+		const float two_pi = 2 * (float)EIGEN_PI;
+		float position = (rotation / two_pi - floor(rotation / two_pi)) * profile.size();
+		int sample = min((int)position, (int)profile.size() - 1);
+		float t = position - sample;
+		return m_vert.speed * ((1 - t) * profile[sample] + t * profile[(sample + 1) % profile.size()]);
+	}
+
+	// advances[m] (may be nullptr) receives how far motor m turned, current_rotation itself wraps around
+	static void advance_motors(float dt, vector<float>* advances = nullptr) {
+		const float two_pi = 2 * (float)EIGEN_PI;
+		if (advances != nullptr) advances->clear();
+		for (MotorizedVertex& m_vert : motorized_verts) {
+			// midpoint rule in substeps that turn at most an eighth of a profile interval at the fastest sample,
+			// so a long frame follows every change of the speed instead of sampling the profile once
+			const vector<float>& profile = m_vert.speed_profile;
+			int num_substeps = 1;
+			if (!profile.empty()) {
+				float peak = 0;
+				for (float p : profile) peak = max(peak, abs(p));
+				float max_angle = 0.125f * two_pi / profile.size();
+				num_substeps = (int)min(4096.0f, max(1.0f, ceil(abs(m_vert.speed * peak * dt) / max_angle)));
+			}
+			const float h = dt / num_substeps;
+			float rotation = m_vert.current_rotation;
+			for (int i = 0; i < num_substeps; i++) {
+				float half_step = rotation + 0.5f * h * motor_speed(m_vert, rotation);
+				rotation += h * motor_speed(m_vert, half_step);
 			}
+			float advance = rotation - m_vert.current_rotation;
+			m_vert.current_rotation = fmod(rotation, two_pi);
+			if (advances != nullptr) advances->push_back(advance);
 		}
 	}
 
+	void set_branch_tracking(bool enabled) {
+		stop_simulation_thread();
+		branch_tracking = enabled;
+		tracked_positions.assign(num_vertices, Vector2f::Zero());
+		tracked_velocities.assign(num_vertices, Vector2f::Zero());
+		tracked_frames = 0;
+	}
+
 
 	// --- simulation ---
+
+	static const int loop_closure_max_iterations = 20;
+
+	// Newton-Raphson on |a - b|^2 = length^2 for every loop-closure link, with everything placed by motors
+	// and dyads already in positions. Starts from the previous solution, so while the linkage moves
+	// continuously a few iterations suffice, and the previous assembly mode is kept. Over-constrained
+	// linkages are solved in the least squares sense (normal equations). Writes NaN for the loop-closure
+	// vertices and keeps the previous solution if it does not converge.
+	bool solve_loop_closure(Matrix2Xd& positions) {
+		const int num_unknowns = loop_closure_positions.size();
+		const int num_links = loop_closure_links.size();
+		VectorXd solution = loop_closure_positions;
+		auto position = [&](int v) -> Vector2d {
+			int slot = loop_closure_slot[v];
+			return slot >= 0 ? Vector2d(solution.segment<2>(2 * slot)) : Vector2d(positions.col(v));
+		};
+		double tolerance = 0;
+		for (const LoopClosureLink& link : loop_closure_links) {
+			tolerance = max(tolerance, 1e-10 * link.length * link.length);
+		}
+
+		VectorXd residuals(num_links), step;
+		SparseMatrix<double> jacobian(num_links, num_unknowns);
+		vector<Triplet<double>> entries;
+		SparseLU<SparseMatrix<double>> lu;
+		bool converged = false;
+		for (loop_closure_iterations = 0; loop_closure_iterations <= loop_closure_max_iterations; loop_closure_iterations++) {
+			entries.clear();
+			for (int l = 0; l < num_links; l++) {
+				const LoopClosureLink& link = loop_closure_links[l];
+				Vector2d ab = position(link.vertex_a) - position(link.vertex_b);
+				residuals(l) = ab.squaredNorm() - link.length * link.length;
+				int slot_a = loop_closure_slot[link.vertex_a], slot_b = loop_closure_slot[link.vertex_b];
+				if (slot_a >= 0) {
+					entries.emplace_back(l, 2 * slot_a, 2 * ab.x());
+					entries.emplace_back(l, 2 * slot_a + 1, 2 * ab.y());
+				}
+				if (slot_b >= 0) {
+					entries.emplace_back(l, 2 * slot_b, -2 * ab.x());
+					entries.emplace_back(l, 2 * slot_b + 1, -2 * ab.y());
+				}
+			}
+			if (!residuals.allFinite()) break;
+			if (residuals.lpNorm<Infinity>() <= tolerance) {
+				converged = true;
+				break;
+			}
+			if (loop_closure_iterations == loop_closure_max_iterations) break;
+
+			jacobian.setFromTriplets(entries.begin(), entries.end());
+			if (num_links == num_unknowns) {
+				lu.compute(jacobian);
+				if (lu.info() != Success) break;
+				step = lu.solve(residuals);
+			} else {
+				SparseMatrix<double> normal = jacobian.transpose() * jacobian;
+				lu.compute(normal);
+				if (lu.info() != Success) break;
+				step = lu.solve(jacobian.transpose() * residuals);
+			}
+			if (!step.allFinite()) break;
+			solution -= step;
+		}
+
+		if (converged) loop_closure_positions = solution;
+		for (int v = 0; v < loop_closure_verts.size(); v++) {
+			positions.col(loop_closure_verts[v]) = converged
+				? Vector2d(solution.segment<2>(2 * v)) : Vector2d::Constant(numeric_limits<double>::quiet_NaN());
+		}
+		return converged;
+	}
 	
-	void get_simulated_positions(float* x_output_array, float* y_output_array) {
+	// Margin to singularity of a dyad: 1 - |cos(phi)| of the law of cosines, 0 when the triangle is flat
+	// (the dyad is stretched or folded) and negative when it cannot close. A vertex is only as good
+	// as the dyads it depends on, so the margin is the minimum along its chain (1 for static and motorized
+	// vertices). NaN (coinciding neighbours) counts as -1.
+	// advance_tracking = false evaluates an in-between state (see get_interpolated_positions()) without
+	// switching branches or adding to the branch tracking history
+	static void simulate_frame(float* x_output_array, float* y_output_array, float* margin, bool advance_tracking = true) {
 
 		// static
 		for (StaticVertex s_vert : static_verts) {
 			x_output_array[s_vert.index] = s_vert.initial_x;
 			y_output_array[s_vert.index] = s_vert.initial_y;
+			if (margin != nullptr) margin[s_vert.index] = 1;
 		}
 
 		// motorized
 		for (MotorizedVertex m_vert : motorized_verts) {
 			Vector2f motor_position(x_output_array[m_vert.motor_vertex], y_output_array[m_vert.motor_vertex]);
 
-			Rotation2D rot(m_vert.current_rotation);
+			Rotation2D rot(m_vert.current_rotation + m_vert.phase_offset);
 			Vector2f rotated_position = rot.toRotationMatrix() * Vector2f(m_vert.distance_to_motor, 0) + motor_position;
 
 			x_output_array[m_vert.index] = rotated_position.x();
 			y_output_array[m_vert.index] = rotated_position.y();
+			if (margin != nullptr) margin[m_vert.index] = 1;
 		}
 
-		// dynamic
-		for (DynamicVertex d_vert : dynamic_verts) {
-
+		// dynamic, in order of dependence
+		for (int index_k : ordered_dymanic_indices) {
+			DynamicVertex& d_vert = *static_cast<DynamicVertex*>(all_verts[index_k]);
 
 			Vector2f i(x_output_array[d_vert.dependant_i], y_output_array[d_vert.dependant_i]);
 			Vector2f j(x_output_array[d_vert.dependant_j], y_output_array[d_vert.dependant_j]);
 			float dist_ik = d_vert.distance_to_i;
 			float dist_jk = d_vert.distance_to_j;
 			float dist_ij = (i - j).norm();
-			float phi = acos(
-				(dist_ij * dist_ij + dist_ik * dist_ik - dist_jk * dist_jk)
-				/ (2 * dist_ij * dist_ik)
-			);
+			float cos_phi = (dist_ij * dist_ij + dist_ik * dist_ik - dist_jk * dist_jk) / (2 * dist_ij * dist_ik);
+			if (margin != nullptr) {
+				float own_margin = 1 - abs(cos_phi);
+				margin[index_k] = min(own_margin == own_margin ? own_margin : -1.0f,
+					min(margin[d_vert.dependant_i], margin[d_vert.dependant_j]));
+			}
+			if (branch_tracking) {
+				cos_phi = min(1.0f, max(-1.0f, cos_phi)); // stretched out instead of NaN
+			}
+			float phi = acos(cos_phi);
 
 			Rotation2D phi_rotation(phi);
 			Vector2f k = phi_rotation.toRotationMatrix() * (dist_ik * (j - i) / (j - i).norm()) + i;
+			if (branch_tracking && advance_tracking && tracked_frames >= 2) {
+				// the mirror image across i-j is the other branch, take whichever continues the motion
+				Vector2f mirrored_k = Rotation2D(-phi).toRotationMatrix() * (dist_ik * (j - i) / (j - i).norm()) + i;
+				Vector2f predicted = tracked_positions[index_k] + tracked_velocities[index_k];
+				if ((mirrored_k - predicted).squaredNorm() < (k - predicted).squaredNorm()) {
+					// the flip rewrites the dyad plan, which a running exploration reads. Never the case on the
+					// simulation thread, the two exclude each other.
+					stop_design_exploration();
+					d_vert.swap_dependants();
+					d_vert.mirrored = !d_vert.mirrored;
+					k = mirrored_k;
+				}
+			}
 			x_output_array[d_vert.index] = k.x(); y_output_array[d_vert.index] = k.y();
 		}
-	}
-
 
-	// DEPRECATED
-
-	// i, j, k according to Disney paper
-	// This assumes that i -> j -> k traverses the triangle counter-clockwise.
-	void symbolic_kinematic(
-		float* i_array, float* j_array,
-		float dist_ik, float dist_jk,
-		float* output_array
-	) {
-		Vector2f i(i_array[0], i_array[1]);
-		Vector2f j(j_array[0], j_array[1]);
-		float dist_ij = (i - j).norm();
-		float phi = acos(
-			(dist_ij * dist_ij + dist_ik * dist_ik - dist_jk * dist_jk)
-			/ (2 * dist_ij * dist_ik)
-		);
+		// the rest from their loop-closure constraints
+		if (!loop_closure_verts.empty()) {
+			Matrix2Xd positions(2, num_vertices);
+			for (int v = 0; v < num_vertices; v++) {
+				positions.col(v) = Vector2d(x_output_array[v], y_output_array[v]);
+			}
+			bool solved = solve_loop_closure(positions);
+			for (int v : loop_closure_verts) {
+				x_output_array[v] = positions(0, v); y_output_array[v] = positions(1, v);
+				if (margin != nullptr) margin[v] = solved ? 1 : -1; // no margin known, only whether it closed
+			}
+		}
 
-		Rotation2D phi_rotation(phi);
-		Vector2f k = phi_rotation.toRotationMatrix() * (dist_ik * (j - i) / (j - i).norm()) + i;
-		output_array[0] = k.x(); output_array[1] = k.y();
+		if (branch_tracking && advance_tracking) {
+			for (int v = 0; v < num_vertices; v++) {
+				Vector2f position(x_output_array[v], y_output_array[v]);
+				tracked_velocities[v] = tracked_frames > 0 ? Vector2f(position - tracked_positions[v]) : Vector2f::Zero();
+				tracked_positions[v] = position;
+			}
+			tracked_frames++;
+		}
 	}
 
+	void get_simulated_positions(float* x_output_array, float* y_output_array) {
+		stop_simulation_thread();
+		simulate_frame(x_output_array, y_output_array, nullptr);
+	}
 
-	dual get_edge_length_gardient(const VectorXdual& edge_lengths, const int vert_index, const Vector2dual& target_pos) {
-		
-		// Step 1: simulate all the positions
-		MatrixXdual positions(2, num_vertices); // x = coordinate, y = value
+	void register_output_buffers(float* xy, int capacity) {
+		output_xy = capacity > 0 ? xy : nullptr;
+		output_capacity = output_xy != nullptr ? capacity : 0;
+	}
 
-		// static
-		for (StaticVertex s_vert : static_verts) {
-			positions(0, s_vert.index) = s_vert.initial_x;
-			positions(1, s_vert.index) = s_vert.initial_y;
+	// Transforms of every edge, for each column of positions (vertices x linkages), computed across the columns
+	// at once and written linkage after linkage. Format 0 is midpoint x, y and the vector from the first to the second
+	// vertex (direction times length, no trigonometry needed); format 1 a 4x4 column-major translate * rotate about z
+	// * scale x by the length (a unit bar along x becomes the link).
+	template<typename Positions>
+	static void write_edge_transforms(const Positions& x, const Positions& y, int format, float* out) {
+		const int num_edges = edges.size(), count = x.cols();
+		// one row per edge, computed across the columns, then written out linkage by linkage
+		Array<float, Dynamic, Dynamic, RowMajor> mid_x(num_edges, count), mid_y(num_edges, count), dx(num_edges, count),
+			dy(num_edges, count), length;
+		for (int e = 0; e < num_edges; e++) {
+			int a = edges[e].first, b = edges[e].second;
+			mid_x.row(e) = 0.5f * (x.row(a) + x.row(b));
+			mid_y.row(e) = 0.5f * (y.row(a) + y.row(b));
+			dx.row(e) = x.row(b) - x.row(a);
+			dy.row(e) = y.row(b) - y.row(a);
 		}
-		
-		// motorized
-		for (MotorizedVertex m_vert : motorized_verts) {
-			Vector2dual motor_position(positions(0, m_vert.motor_vertex), positions(1, m_vert.motor_vertex));
-			
-			dual current_rotation = dual(); current_rotation = m_vert.current_rotation;
-			Rotation2D rot(current_rotation);
-			dual distance_to_motor = dual(); distance_to_motor = m_vert.distance_to_motor;
-			for (int i = 0; i < edges.size(); i++) {
-				if ((edges[i].first == m_vert.index && edges[i].second == m_vert.motor_vertex)
-					|| (edges[i].first == m_vert.motor_vertex && edges[i].second == m_vert.index)) {
-					distance_to_motor = edge_lengths[i];
+		if (format == 0) {
+			for (int i = 0; i < count; i++) {
+				for (int e = 0; e < num_edges; e++, out += 4) {
+					out[0] = mid_x(e, i);
+					out[1] = mid_y(e, i);
+					out[2] = dx(e, i);
+					out[3] = dy(e, i);
 				}
 			}
-			Vector2dual horizontal(distance_to_motor, 0);
-			 
-			Vector2dual rotated_position = Vector2dual(
-				(MatrixXdual(rot.toRotationMatrix()) * horizontal + motor_position));
+			return;
+		}
+		length = (dx.square() + dy.square()).sqrt();
+		Array<float, Dynamic, Dynamic, RowMajor> cos_angle = (length > 0).select(dx / length, 1.0f);
+		Array<float, Dynamic, Dynamic, RowMajor> sin_angle = (length > 0).select(dy / length, 0.0f);
+		for (int i = 0; i < count; i++) {
+			for (int e = 0; e < num_edges; e++, out += 16) {
+				const float c = cos_angle(e, i), s = sin_angle(e, i);
+				const float matrix[16] = { dx(e, i), dy(e, i), 0, 0, -s, c, 0, 0, 0, 0, 1, 0, mid_x(e, i), mid_y(e, i), 0, 1 };
+				copy(begin(matrix), end(matrix), out);
+			}
+		}
+	}
 
-			positions(0, m_vert.index) = rotated_position.x();
-			positions(1, m_vert.index) = rotated_position.y();
+	static int write_output_buffer(const vector<float>& x, const vector<float>& y) {
+		if (output_xy == nullptr || output_capacity < num_vertices) return -1;
+		for (int v = 0; v < num_vertices; v++) {
+			output_xy[2 * v] = x[v];
+			output_xy[2 * v + 1] = y[v];
 		}
-		
-		// dynamic
-		for (DynamicVertex d_vert : dynamic_verts) {
+		if (edge_output != nullptr && edge_output_capacity >= (int)edges.size()) {
+			write_edge_transforms(Map<const ArrayXf>(x.data(), num_vertices), Map<const ArrayXf>(y.data(), num_vertices),
+				edge_output_format, edge_output);
+		}
+		return ++output_generation;
+	}
 
-			
-			Vector2dual i(positions(0, d_vert.dependant_i), positions(1, d_vert.dependant_i));
-			Vector2dual j(positions(0, d_vert.dependant_j), positions(1, d_vert.dependant_j));
-			dual dist_ik = dual(); dist_ik = d_vert.distance_to_i;
-			dual dist_jk = dual();  dist_jk = d_vert.distance_to_j;
-			dual dist_ij = Vector2dual(i - j).norm();
-			int index_k = d_vert.index, index_i = d_vert.dependant_i, index_j = d_vert.dependant_j;
-			
-			// quick-n-dirty solution
-			for (int e = 0; e < edges.size(); e++) {
-				if ((edges[e].first == index_i && edges[e].second == index_k)
-					|| (edges[e].first == index_k && edges[e].second == index_i)) {
-					dist_ik = edge_lengths[e];
-					break;
-				}
-			}
-			for (int e = 0; e < edges.size(); e++) {
-				if ((edges[e].first == index_j && edges[e].second == index_k)
-					|| (edges[e].first == index_k && edges[e].second == index_j)) {
-					dist_jk = edge_lengths[e];
-					break;
-				}
-			}
-			for (int e = 0; e < edges.size(); e++) {
-				if ((edges[e].first == index_i && edges[e].second == index_j)
-					|| (edges[e].first == index_j && edges[e].second == index_i)) {
-					dist_ij = edge_lengths[e];
-					break;
-				}
-			}
-			dual phi = dual(); phi = acos(
-				(dist_ij * dist_ij + dist_ik * dist_ik - dist_jk * dist_jk)
-				/ (2 * dist_ij * dist_ik)
-			);
+	void register_edge_output_buffer(float* transforms, int capacity, int format) {
+		bool valid = transforms != nullptr && capacity > 0 && (format == 0 || format == 1);
+		edge_output = valid ? transforms : nullptr;
+		edge_output_capacity = valid ? capacity : 0;
+		edge_output_format = valid ? format : 0;
+	}
 
-			Rotation2D phi_rotation(phi);
-			Vector2dual k = Vector2dual(MatrixXdual(phi_rotation.toRotationMatrix()) * dist_ik * (j - i) / Vector2dual(j - i).norm() + i);
-			positions(0, d_vert.index) = k.x(); positions(1, d_vert.index) = k.y();
+	int simulate() {
+		stop_simulation_thread();
+		if (output_xy == nullptr || output_capacity < num_vertices) return -1;
+		frame_x.resize(num_vertices);
+		frame_y.resize(num_vertices);
+		simulate_frame(frame_x.data(), frame_y.data(), nullptr);
+		return write_output_buffer(frame_x, frame_y);
+	}
+
+	int step(float dt) {
+		stop_simulation_thread();
+		if (output_xy == nullptr || output_capacity < num_vertices) return -1; // before anything moves
+		advance_motors(dt, &stepped_advances);
+		frame_x.resize(num_vertices);
+		frame_y.resize(num_vertices);
+		simulate_frame(frame_x.data(), frame_y.data(), nullptr);
+
+		// keep this state and the one before for get_interpolated_positions()
+		swap(stepped_states[0], stepped_states[1]);
+		SteppedState& latest = stepped_states[1];
+		latest.x = frame_x;
+		latest.y = frame_y;
+		latest.speeds.clear();
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			latest.speeds.push_back(motor_speed(m_vert, m_vert.current_rotation));
 		}
-		
-		// Step 2: check current error
-		Vector2dual current_position_of_vertex(positions(0, vert_index), positions(1, vert_index));
-		dual error = dual(); error = Vector2dual(current_position_of_vertex - target_pos).norm();
-		return error;
+		bool continues = num_stepped_states > 0 && stepped_states[0].x.size() == num_vertices;
+		num_stepped_states = continues ? 2 : 1;
+		stepped_dt = dt;
+		return write_output_buffer(frame_x, frame_y);
 	}
 
+	int get_output_generation() {
+		return output_generation;
+	}
 
-	void get_edge_length_gradients_for_target_position(
-		int vertex_index, float x, float y,
-		float* first_end, float* second_end, float* gradient_for_edge)
-	{
-		
-		VectorXdual edge_lengths = VectorXdual(edges.size());
-		for (int i = 0; i < edges.size(); i++) {
-			Vector2f v1(all_verts[edges[i].first]->initial_x, all_verts[edges[i].first]->initial_y);
-			Vector2f v2(all_verts[edges[i].second]->initial_x, all_verts[edges[i].second]->initial_y);
-			edge_lengths(i) = (v1 - v2).norm();
+	void get_simulated_positions_with_margin(float* x_output_array, float* y_output_array, float* margin, int* valid) {
+		stop_simulation_thread();
+		vector<float> margin_buffer;
+		if (margin == nullptr) {
+			margin_buffer.resize(num_vertices);
+			margin = margin_buffer.data();
+		}
+		simulate_frame(x_output_array, y_output_array, margin);
+		if (valid != nullptr) {
+			for (int v = 0; v < num_vertices; v++) {
+				valid[v] = margin[v] >= 0 ? 1 : 0;
+			}
 		}
+	}
 
-		dual magnitude;
-		VectorXd g = gradient(
-			get_edge_length_gardient,
-			wrt(edge_lengths),
-			at(edge_lengths, vertex_index, Vector2dual(x, y)),
-			magnitude);
 
+	// current length of every edge, as used by the simulation (dyad distances may have been optimized)
+	VectorXd current_edge_lengths() {
+		VectorXd edge_lengths = VectorXd(edges.size());
 		for (int i = 0; i < edges.size(); i++) {
-			first_end[i] = edges[i].first;
-			second_end[i] = edges[i].second;
-			gradient_for_edge[i] = g(i);
+			Vector2d v1(all_verts[edges[i].first]->initial_x, all_verts[edges[i].first]->initial_y);
+			Vector2d v2(all_verts[edges[i].second]->initial_x, all_verts[edges[i].second]->initial_y);
+			edge_lengths(i) = (v1 - v2).norm();
 		}
-
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			if (m_vert.edge_to_motor >= 0) edge_lengths(m_vert.edge_to_motor) = m_vert.distance_to_motor;
+		}
+		for (const DynamicVertex& d_vert : dynamic_verts) {
+			if (d_vert.edge_to_i >= 0) edge_lengths(d_vert.edge_to_i) = d_vert.distance_to_i;
+			if (d_vert.edge_to_j >= 0) edge_lengths(d_vert.edge_to_j) = d_vert.distance_to_j;
+		}
+		for (const LoopClosureLink& link : loop_closure_links) {
+			edge_lengths(link.edge) = link.length;
+		}
+		return edge_lengths;
 	}
 
+	// writes optimized edge lengths back into the vertices, so that get_simulated_positions uses them
+	void apply_edge_lengths(const VectorXd& edge_lengths) {
+		for (MotorizedVertex& m_vert : motorized_verts) {
+			if (m_vert.edge_to_motor >= 0) m_vert.distance_to_motor = edge_lengths(m_vert.edge_to_motor);
+		}
+		for (DynamicVertex& d_vert : dynamic_verts) {
+			if (d_vert.edge_to_i >= 0) d_vert.distance_to_i = edge_lengths(d_vert.edge_to_i);
+			if (d_vert.edge_to_j >= 0) d_vert.distance_to_j = edge_lengths(d_vert.edge_to_j);
+		}
+		for (LoopClosureLink& link : loop_closure_links) {
+			link.length = edge_lengths(link.edge);
+		}
+	}
 
-	// --- optimization ---
+	// edges that actually drive the simulation (dyad links and cranks), others have no effect on positions
+	vector<bool> active_edge_mask() {
+		vector<bool> mask(edges.size(), false);
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			if (m_vert.edge_to_motor >= 0) mask[m_vert.edge_to_motor] = true;
+		}
+		for (const DynamicVertex& d_vert : dynamic_verts) {
+			if (d_vert.edge_to_i >= 0) mask[d_vert.edge_to_i] = true;
+			if (d_vert.edge_to_j >= 0) mask[d_vert.edge_to_j] = true;
+		}
+		return mask;
+	}
 
-	struct grad_and_objective { VectorXd grad; double objective; };
-	grad_and_objective gradient_and_objective_for_target_position(
-		const VectorXd& input_edge_lengths,
-		int vertex_index, float x, float y)
-	{
-		VectorXdual edge_lengths = VectorXdual(input_edge_lengths.size());
-		for (int i = 0; i < input_edge_lengths.size(); i++) {
-			edge_lengths(i) = input_edge_lengths(i);
+	vector<float> current_motor_rotations() {
+		vector<float> rotations;
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			rotations.push_back(m_vert.current_rotation);
 		}
+		return rotations;
+	}
 
-		dual magnitude;
-		VectorXd g = gradient(
-			get_edge_length_gardient,
-			wrt(edge_lengths),
-			at(edge_lengths, vertex_index, Vector2dual(x, y)),
-			magnitude);
+	// --- linkage parameters ---
+
+	// Everything that shapes the motion, as one vector:
+	//   [ edge lengths | anchor x0, y0, x1, y1, ... | motor radii | motor phase offsets ]
+	// with anchors in the order of static_verts and motors in the order of motorized_verts.
+	// A crank that also has an explicit edge is driven by its radius entry.
+	int anchor_parameter(int static_number) { return edges.size() + 2 * static_number; }
+	int radius_parameter(int motor_number) { return edges.size() + 2 * static_verts.size() + motor_number; }
+	int phase_parameter(int motor_number) { return radius_parameter(motorized_verts.size()) + motor_number; }
+	int parameter_count() { return phase_parameter(motorized_verts.size()); }
+
+	VectorXd current_parameters() {
+		VectorXd parameters(parameter_count());
+		parameters.head(edges.size()) = current_edge_lengths();
+		int s = 0;
+		for (const StaticVertex& s_vert : static_verts) {
+			parameters(anchor_parameter(s)) = s_vert.initial_x;
+			parameters(anchor_parameter(s) + 1) = s_vert.initial_y;
+			s++;
+		}
+		int m = 0;
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			parameters(radius_parameter(m)) = m_vert.distance_to_motor;
+			parameters(phase_parameter(m)) = m_vert.phase_offset;
+			m++;
+		}
+		return parameters;
+	}
 
-		VectorXd grad = VectorXd(input_edge_lengths.size());
-		for (int i = 0; i < g.size(); i++) {
-			grad(i) = - g(i);
+	void apply_parameters(const VectorXd& parameters) {
+		apply_edge_lengths(parameters.head(edges.size()));
+		int s = 0;
+		for (StaticVertex& s_vert : static_verts) {
+			s_vert.initial_x = parameters(anchor_parameter(s));
+			s_vert.initial_y = parameters(anchor_parameter(s) + 1);
+			s++;
+		}
+		int m = 0;
+		for (MotorizedVertex& m_vert : motorized_verts) {
+			m_vert.distance_to_motor = parameters(radius_parameter(m));
+			m_vert.phase_offset = parameters(phase_parameter(m));
+			m++;
 		}
-		grad_and_objective ret;
-		ret.grad = grad;
-		ret.objective = magnitude.val;
-		return ret;
 	}
 
-	template<typename T> class EdgeLengthMinimizer : public Problem<T> {
-	public:
-		using typename Problem<T>::TVector;
+	// Places dyad vertex k from its two already placed neighbours i and j (law of cosines). i -> j -> k runs
+	// counter-clockwise, so passing j and i (with their distances) instead gives the other assembly mode.
+	// Coordinates become NaN if the dyad does not assemble.
+	template<typename T>
+	void place_dyad(int index_k, int index_i, int index_j, const T& dist_ik, const T& dist_jk, Matrix<T, 2, Dynamic>& positions) {
+		using std::sqrt; using std::acos; using std::cos; using std::sin;
+		T ij_x = positions(0, index_j) - positions(0, index_i);
+		T ij_y = positions(1, index_j) - positions(1, index_i);
+		T dist_ij = sqrt(ij_x * ij_x + ij_y * ij_y);
+		T phi = acos(
+			(dist_ij * dist_ij + dist_ik * dist_ik - dist_jk * dist_jk)
+			/ (2 * dist_ij * dist_ik)
+		);
+		// rotate (j - i) by phi and scale it to dist_ik
+		T cos_phi = cos(phi), sin_phi = sin(phi);
+		T scale = dist_ik / dist_ij;
+		positions(0, index_k) = positions(0, index_i) + scale * (cos_phi * ij_x - sin_phi * ij_y);
+		positions(1, index_k) = positions(1, index_i) + scale * (sin_phi * ij_x + cos_phi * ij_y);
+	}
 
-		int target_vert = 0;
-		Vector2d target_position;
+	// Simulates all positions for the given linkage parameters (see above) and motor rotations
+	// (in the order of `motorized_verts`). Only reads the global state, so it is safe to call from
+	// multiple threads, and it works for float/double as well as autodiff's dual types.
+	template<typename T>
+	void simulate_for_parameters(const Matrix<T, Dynamic, 1>& parameters, const vector<float>& motor_rotations,
+		Matrix<T, 2, Dynamic>& positions)
+	{
+		using std::sqrt; using std::acos; using std::cos; using std::sin;
+		positions.resize(2, num_vertices);
 
-		void set_target(int vertex_index, float target_x, float target_y) {
-			target_vert = vertex_index;
-			target_position = Vector2d(target_x, target_y);
+		// static
+		int s = 0;
+		for (const StaticVertex& s_vert : static_verts) {
+			positions(0, s_vert.index) = parameters(anchor_parameter(s));
+			positions(1, s_vert.index) = parameters(anchor_parameter(s) + 1);
+			s++;
 		}
 
+		// motorized
+		int m = 0;
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			T radius = parameters(radius_parameter(m));
+			T rotation = T(motor_rotations[m]) + parameters(phase_parameter(m));
+			positions(0, m_vert.index) = positions(0, m_vert.motor_vertex) + radius * cos(rotation);
+			positions(1, m_vert.index) = positions(1, m_vert.motor_vertex) + radius * sin(rotation);
+			m++;
+		}
 
-		// objective function
-		T value(const TVector& x) {
-			auto [grad, obj] = gradient_and_objective_for_target_position(x, target_vert, target_position.x(), target_position.y());
-			return obj;
+		// dynamic, in order of dependence
+		for (int index_k : ordered_dymanic_indices) {
+			const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[index_k]);
+			T dist_ik = d_vert->edge_to_i >= 0 ? T(parameters(d_vert->edge_to_i)) : T(d_vert->distance_to_i);
+			T dist_jk = d_vert->edge_to_j >= 0 ? T(parameters(d_vert->edge_to_j)) : T(d_vert->distance_to_j);
+			place_dyad<T>(index_k, d_vert->dependant_i, d_vert->dependant_j, dist_ik, dist_jk, positions);
 		}
 
-		// optional override of gradient (we calculate it ourselves)
-		void gradient(const TVector& x, TVector& grad) {
-			auto [gradients, obj] = gradient_and_objective_for_target_position(x, target_vert, target_position.x(), target_position.y());
-			for (int i = 0; i < gradients.size(); i++) {
-				grad[i] = gradients(i);
+		// loop-closure vertices are not solved here, they stay where get_simulated_positions() last put them
+		for (int v = 0; v < loop_closure_verts.size(); v++) {
+			positions(0, loop_closure_verts[v]) = T(loop_closure_positions(2 * v));
+			positions(1, loop_closure_verts[v]) = T(loop_closure_positions(2 * v + 1));
+		}
+	}
+
+	// Same, for the given edge lengths (indexed like `edges`) and everything else as it currently is.
+	template<typename T>
+	void simulate_for_edge_lengths(const Matrix<T, Dynamic, 1>& edge_lengths, const vector<float>& motor_rotations,
+		Matrix<T, 2, Dynamic>& positions)
+	{
+		VectorXd current = current_parameters();
+		Matrix<T, Dynamic, 1> parameters(current.size());
+		for (int p = 0; p < current.size(); p++) {
+			parameters(p) = current(p);
+		}
+		parameters.head(edges.size()) = edge_lengths;
+		int m = 0;
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			if (m_vert.edge_to_motor >= 0) parameters(radius_parameter(m)) = edge_lengths(m_vert.edge_to_motor);
+			m++;
+		}
+		simulate_for_parameters(parameters, motor_rotations, positions);
+	}
+
+	// The optimization variables and how they map onto the linkage parameters (see free_parameter_index).
+	struct ParameterSelection {
+		vector<int> index;
+		vector<float> scale;
+		int num_free;
+		VectorXd base; // values of the fixed parameters
+
+		template<typename T>
+		Matrix<T, Dynamic, 1> expand(const Matrix<T, Dynamic, 1>& free) const {
+			Matrix<T, Dynamic, 1> parameters(base.size());
+			for (int p = 0; p < base.size(); p++) {
+				parameters(p) = index[p] >= 0 ? T(scale[p] * free(index[p])) : T(base(p));
 			}
+			return parameters;
 		}
-	};
 
+		// inverse of expand, tied parameters take the value of the first one
+		VectorXd contract(const VectorXd& parameters) const {
+			VectorXd free = VectorXd::Zero(num_free);
+			vector<bool> is_set(num_free, false);
+			for (int p = 0; p < parameters.size(); p++) {
+				if (index[p] < 0 || is_set[index[p]] || scale[p] == 0) continue;
+				free(index[p]) = parameters(p) / scale[p];
+				is_set[index[p]] = true;
+			}
+			return free;
+		}
+	};
 
-	bool optimize_for_target_location(int vertex_index, float x, float y) {
-		// ---------- DEBUG -------------
-		ofstream out("unity_symbo_dll_cout.txt"); cout.rdbuf(out.rdbuf());
-		ofstream err("unity_symbo_dll_cerr.txt"); cerr.rdbuf(err.rdbuf());
-		cout << "writing to cout" << endl;
-		cerr << "writing to cerr" << endl;
-		// ---------- DEBUG -------------
+	// the selection made with select_free_parameters(), by default every active edge and motor radius
+	// is a variable of its own
+	ParameterSelection get_free_parameter_selection() {
+		ParameterSelection selection;
+		selection.base = current_parameters();
+		selection.index = free_parameter_index;
+		selection.scale = free_parameter_scale;
+		if (selection.index.size() != selection.base.size()) {
+			selection.index.assign(selection.base.size(), -1);
+			selection.scale.assign(selection.base.size(), 1);
+			vector<bool> active = active_edge_mask();
+			int m = 0;
+			for (const MotorizedVertex& m_vert : motorized_verts) {
+				if (m_vert.edge_to_motor >= 0) active[m_vert.edge_to_motor] = false; // driven by the radius
+				selection.index[radius_parameter(m++)] = 0;
+			}
+			for (int e = 0; e < edges.size(); e++) {
+				if (active[e]) selection.index[e] = 0;
+			}
+			int next = 0;
+			for (int& i : selection.index) {
+				if (i == 0) i = next++;
+			}
+		}
+		selection.num_free = 0;
+		for (int i : selection.index) {
+			selection.num_free = max(selection.num_free, i + 1);
+		}
+		return selection;
+	}
+
+
+	// --- population simulation ---
+
+	// One row per vertex (or edge), one column per candidate design. Row-major, so that the same
+	// coordinate of all candidates is contiguous and Eigen can vectorize across candidates.
+	// float by default, double where the results are compared against the scalar simulation (line searches).
+	template<typename Scalar>
+	using PopulationArrayOf = Array<Scalar, Dynamic, Dynamic, RowMajor>;
+	using PopulationArray = PopulationArrayOf<float>;
+	static const int population_chunk_size = 256;
+
+	// Simulates candidates [begin, begin + count) of a population into x and y (num_vertices x count).
+	// anchor_positions optionally overrides the static vertices (rows x0, y0, x1, y1, ... in the order
+	// of static_verts), leave it empty to keep them fixed.
+	// Same math as simulate_for_edge_lengths, but phi itself is never needed: cos(phi) is the law of
+	// cosines term and sin(phi) = sqrt(1 - cos(phi)^2) (phi is in [0, pi]), so every step is a plain vector
+	// operation without branches or trigonometry. Designs that do not assemble end up with NaN coordinates.
+	// margin (optional) receives the margin to singularity of every vertex, as in get_simulated_positions_with_margin.
+	// rotation_offsets (optional, one row per motor) is added to motor_rotations per candidate, e.g. to sweep a cycle.
+	template<typename Scalar>
+	void simulate_population_chunk(const PopulationArrayOf<Scalar>& edge_lengths, const PopulationArrayOf<Scalar>& anchor_positions,
+		const vector<float>& motor_rotations, int begin, int count, PopulationArrayOf<Scalar>& x, PopulationArrayOf<Scalar>& y,
+		PopulationArrayOf<Scalar>* margin = nullptr, const PopulationArrayOf<Scalar>* rotation_offsets = nullptr)
+	{
+		using Row = Array<Scalar, 1, Dynamic>;
+		auto length_row = [&](int edge, Scalar fallback) -> Row {
+			return edge >= 0 ? Row(edge_lengths.row(edge).segment(begin, count)) : Row(Row::Constant(count, fallback));
+		};
+		x.resize(num_vertices, count);
+		y.resize(num_vertices, count);
+		if (margin != nullptr) margin->setOnes(num_vertices, count);
+
+		// static
+		int s = 0;
+		for (const StaticVertex& s_vert : static_verts) {
+			if (anchor_positions.rows() > 0) {
+				x.row(s_vert.index) = anchor_positions.row(2 * s).segment(begin, count);
+				y.row(s_vert.index) = anchor_positions.row(2 * s + 1).segment(begin, count);
+			} else {
+				x.row(s_vert.index).setConstant(s_vert.initial_x);
+				y.row(s_vert.index).setConstant(s_vert.initial_y);
+			}
+			s++;
+		}
+
+		// motorized
+		int m = 0;
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			Row radius = length_row(m_vert.edge_to_motor, m_vert.distance_to_motor);
+			Scalar rotation = Scalar(motor_rotations[m]) + m_vert.phase_offset;
+			if (rotation_offsets != nullptr) {
+				Row rotations = rotation_offsets->row(m).segment(begin, count) + rotation;
+				x.row(m_vert.index) = x.row(m_vert.motor_vertex) + radius * rotations.cos();
+				y.row(m_vert.index) = y.row(m_vert.motor_vertex) + radius * rotations.sin();
+			} else {
+				x.row(m_vert.index) = x.row(m_vert.motor_vertex) + radius * cos(rotation);
+				y.row(m_vert.index) = y.row(m_vert.motor_vertex) + radius * sin(rotation);
+			}
+			m++;
+		}
+
+		// dynamic, in order of dependence
+		Row ij_x(count), ij_y(count), dist_ij(count), cos_phi(count), sin_phi(count), scale(count);
+		for (int index_k : ordered_dymanic_indices) {
+			const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[index_k]);
+			Row dist_ik = length_row(d_vert->edge_to_i, d_vert->distance_to_i);
+			Row dist_jk = length_row(d_vert->edge_to_j, d_vert->distance_to_j);
+			ij_x = x.row(d_vert->dependant_j) - x.row(d_vert->dependant_i);
+			ij_y = y.row(d_vert->dependant_j) - y.row(d_vert->dependant_i);
+			dist_ij = (ij_x.square() + ij_y.square()).sqrt();
+			cos_phi = (dist_ij.square() + dist_ik.square() - dist_jk.square()) / (2 * dist_ij * dist_ik);
+			sin_phi = (1 - cos_phi.square()).sqrt();
+			scale = dist_ik / dist_ij;
+			x.row(index_k) = x.row(d_vert->dependant_i) + scale * (cos_phi * ij_x - sin_phi * ij_y);
+			y.row(index_k) = y.row(d_vert->dependant_i) + scale * (sin_phi * ij_x + cos_phi * ij_y);
+			if (margin != nullptr) {
+				Row own_margin = 1 - cos_phi.abs();
+				own_margin = (own_margin == own_margin).select(own_margin, Row::Constant(count, -1));
+				margin->row(index_k) = own_margin.min(margin->row(d_vert->dependant_i)).min(margin->row(d_vert->dependant_j));
+			}
+		}
+
+		// loop-closure vertices stay at their last solution, as in simulate_for_parameters
+		for (int v = 0; v < loop_closure_verts.size(); v++) {
+			x.row(loop_closure_verts[v]).setConstant(loop_closure_positions(2 * v));
+			y.row(loop_closure_verts[v]).setConstant(loop_closure_positions(2 * v + 1));
+		}
+	}
+
+	// Simulates every column of edge_lengths (edges x candidates) at the given motor rotations.
+	// Chunks of candidates are distributed over all cores, unless the caller already runs on a
+	// parallel_for worker (parallel = false), which must not spawn threads of its own.
+	template<typename Scalar>
+	void simulate_population(const PopulationArrayOf<Scalar>& edge_lengths, const PopulationArrayOf<Scalar>& anchor_positions,
+		const vector<float>& motor_rotations, PopulationArrayOf<Scalar>& x, PopulationArrayOf<Scalar>& y, bool parallel = true)
+	{
+		const int population = edge_lengths.cols();
+		x.resize(num_vertices, population);
+		y.resize(num_vertices, population);
+		const int num_chunks = (population + population_chunk_size - 1) / population_chunk_size;
+		auto simulate_chunk = [&](int c) {
+			int begin = c * population_chunk_size;
+			int count = min(population_chunk_size, population - begin);
+			PopulationArrayOf<Scalar> chunk_x, chunk_y;
+			simulate_population_chunk(edge_lengths, anchor_positions, motor_rotations, begin, count, chunk_x, chunk_y);
+			x.middleCols(begin, count) = chunk_x;
+			y.middleCols(begin, count) = chunk_y;
+		};
+		if (!parallel) {
+			for (int c = 0; c < num_chunks; c++) simulate_chunk(c);
+			return;
+		}
+		parallel_for(num_chunks, simulate_chunk);
+	}
+
+	// cos of the transmission angle of dyad k (the angle between its links k-i and k-j) for every candidate
+	template<typename Scalar>
+	Array<Scalar, 1, Dynamic> transmission_cosine(const PopulationArrayOf<Scalar>& x, const PopulationArrayOf<Scalar>& y, int index_k) {
+		using Row = Array<Scalar, 1, Dynamic>;
+		const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[index_k]);
+		Row ik_x = x.row(index_k) - x.row(d_vert->dependant_i), ik_y = y.row(index_k) - y.row(d_vert->dependant_i);
+		Row jk_x = x.row(index_k) - x.row(d_vert->dependant_j), jk_y = y.row(index_k) - y.row(d_vert->dependant_j);
+		return (ik_x * jk_x + ik_y * jk_y) / ((ik_x.square() + ik_y.square()) * (jk_x.square() + jk_y.square())).sqrt();
+	}
+
+	// d(position) / d(motor rotation) of every vertex of a simulated chunk, all motors turning together,
+	// or, with motor_rates (per motor, in the order they were added), the velocity when they turn at these rates.
+	// A dyad keeps its distances to i and j, so (k - i).(v_k - v_i) = 0 and (k - j).(v_k - v_j) = 0:
+	// a 2x2 system per candidate, solved with Cramer's rule. Loop-closure vertices are treated as fixed.
+	template<typename Scalar>
+	void population_velocities(const PopulationArrayOf<Scalar>& x, const PopulationArrayOf<Scalar>& y,
+		PopulationArrayOf<Scalar>& vx, PopulationArrayOf<Scalar>& vy, const vector<float>* motor_rates = nullptr)
+	{
+		using Row = Array<Scalar, 1, Dynamic>;
+		vx.setZero(x.rows(), x.cols());
+		vy.setZero(x.rows(), x.cols());
+		int m = 0;
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			Scalar rate = motor_rates != nullptr ? Scalar((*motor_rates)[m]) : Scalar(1);
+			vx.row(m_vert.index) = vx.row(m_vert.motor_vertex) - rate * (y.row(m_vert.index) - y.row(m_vert.motor_vertex));
+			vy.row(m_vert.index) = vy.row(m_vert.motor_vertex) + rate * (x.row(m_vert.index) - x.row(m_vert.motor_vertex));
+			m++;
+		}
+		for (int index_k : ordered_dymanic_indices) {
+			const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[index_k]);
+			int i = d_vert->dependant_i, j = d_vert->dependant_j;
+			Row ik_x = x.row(index_k) - x.row(i), ik_y = y.row(index_k) - y.row(i);
+			Row jk_x = x.row(index_k) - x.row(j), jk_y = y.row(index_k) - y.row(j);
+			Row b_i = ik_x * vx.row(i) + ik_y * vy.row(i);
+			Row b_j = jk_x * vx.row(j) + jk_y * vy.row(j);
+			Row det = ik_x * jk_y - ik_y * jk_x;
+			vx.row(index_k) = (b_i * jk_y - ik_y * b_j) / det;
+			vy.row(index_k) = (ik_x * b_j - jk_x * b_i) / det;
+		}
+	}
+
+	// the current design once per sampled rotation (from..to, inclusive), as a population whose motor
+	// rotations come from the offsets. One column per rotation instead of per design, so a sweep
+	// vectorizes the same way as a population.
+	void rotation_sweep(float from, float to, int num_samples, PopulationArray& edge_lengths, PopulationArray& offsets) {
+		const float step = num_samples > 1 ? (to - from) / (num_samples - 1) : 0;
+		edge_lengths = current_edge_lengths().cast<float>().replicate(1, num_samples).array();
+		offsets.resize(motorized_verts.size(), num_samples);
+		for (int s = 0; s < num_samples; s++) {
+			offsets.col(s).setConstant(from + s * step);
+		}
+	}
+
+	bool find_first_invalid_rotation(float from, float to, int num_samples, float* rotation, float* min_margin) {
+		stop_simulation_thread();
+		if (num_samples <= 0) return false;
+		const float step = num_samples > 1 ? (to - from) / (num_samples - 1) : 0;
+		PopulationArray edge_lengths, offsets;
+		rotation_sweep(from, to, num_samples, edge_lengths, offsets);
+		const vector<float> rotations(motorized_verts.size(), 0); // all of it comes from the offsets
+
+		const int num_chunks = (num_samples + population_chunk_size - 1) / population_chunk_size;
+		vector<int> first_invalid(num_chunks, num_samples);
+		vector<float> chunk_margin(num_chunks, 1);
+		parallel_for(num_chunks, [&](int c) {
+			int begin = c * population_chunk_size;
+			int count = min(population_chunk_size, num_samples - begin);
+			PopulationArray x, y, margin;
+			simulate_population_chunk(edge_lengths, PopulationArray(), rotations, begin, count, x, y, &margin, &offsets);
+			Array<float, 1, Dynamic> sample_margin = margin.colwise().minCoeff();
+			chunk_margin[c] = sample_margin.minCoeff();
+			for (int i = 0; i < count; i++) {
+				if (sample_margin(i) < 0) {
+					first_invalid[c] = begin + i;
+					break;
+				}
+			}
+		});
+
+		if (min_margin != nullptr) *min_margin = *min_element(chunk_margin.begin(), chunk_margin.end());
+		int first = *min_element(first_invalid.begin(), first_invalid.end());
+		if (first == num_samples) return false;
+		if (rotation != nullptr) *rotation = from + first * step;
+		return true;
+	}
+
+	static vector<unsigned char> baked_cycle; // blob of the last bake_cycle(), see BakedCycle.h
+
+	// Fits a blob of num_segments uniform segments, a cubic Hermite between the exact positions and derivatives at
+	// the knots, and records per vertex the largest deviation from the simulation at samples_per_segment - 1 test
+	// angles inside every segment, times safety. Returns the largest of them, NaN if some angle does not assemble.
+	static float fit_baked_cycle(int num_segments, int samples_per_segment, float safety, vector<unsigned char>& blob) {
+		const float two_pi = 2 * (float)EIGEN_PI;
+		const vector<float> rotations(motorized_verts.size(), 0);
+		// every angle of this resolution in one batch, with the exact derivative by the rotation at each
+		const int num_samples = samples_per_segment * num_segments;
+		PopulationArray edge_lengths, offsets;
+		rotation_sweep(0, two_pi * (num_samples - 1) / num_samples, num_samples, edge_lengths, offsets);
+		PopulationArray x(num_vertices, num_samples), y(num_vertices, num_samples);
+		PopulationArray vx(num_vertices, num_samples), vy(num_vertices, num_samples);
+		const int num_chunks = (num_samples + population_chunk_size - 1) / population_chunk_size;
+		parallel_for(num_chunks, [&](int c) {
+			int begin = c * population_chunk_size;
+			int count = min(population_chunk_size, num_samples - begin);
+			PopulationArray chunk_x, chunk_y, chunk_vx, chunk_vy;
+			simulate_population_chunk<float>(edge_lengths, PopulationArray(), rotations, begin, count, chunk_x, chunk_y, nullptr, &offsets);
+			population_velocities(chunk_x, chunk_y, chunk_vx, chunk_vy);
+			x.middleCols(begin, count) = chunk_x;
+			y.middleCols(begin, count) = chunk_y;
+			vx.middleCols(begin, count) = chunk_vx;
+			vy.middleCols(begin, count) = chunk_vy;
+		});
+		if (!x.allFinite() || !y.allFinite() || !vx.allFinite() || !vy.allFinite()) return numeric_limits<float>::quiet_NaN();
+
+		blob.assign(baked_cycle_size(num_vertices, num_segments), 0);
+		BakedCycleHeader* header = reinterpret_cast<BakedCycleHeader*>(blob.data());
+		copy(begin(baked_cycle_magic), end(baked_cycle_magic), header->magic);
+		header->version = baked_cycle_version;
+		header->num_vertices = num_vertices;
+		header->num_segments = num_segments;
+		float* error = reinterpret_cast<float*>(header + 1);
+		float* coefficients = error + num_vertices;
+		const float h = two_pi / num_segments;
+		for (int segment = 0; segment < num_segments; segment++) {
+			int k0 = samples_per_segment * segment, k1 = samples_per_segment * ((segment + 1) % num_segments);
+			for (int v = 0; v < num_vertices; v++) {
+				float* c = coefficients + ((size_t)segment * num_vertices + v) * 8;
+				for (int axis = 0; axis < 2; axis++) {
+					const PopulationArray& p = axis == 0 ? x : y;
+					const PopulationArray& dp = axis == 0 ? vx : vy;
+					float p0 = p(v, k0), p1 = p(v, k1), m0 = h * dp(v, k0), m1 = h * dp(v, k1);
+					c[4 * axis] = 2 * p0 - 2 * p1 + m0 + m1;
+					c[4 * axis + 1] = -3 * p0 + 3 * p1 - 2 * m0 - m1;
+					c[4 * axis + 2] = m0;
+					c[4 * axis + 3] = p0;
+				}
+				for (int test = 1; test < samples_per_segment; test++) {
+					float t = (float)test / samples_per_segment;
+					float baked_x = ((c[0] * t + c[1]) * t + c[2]) * t + c[3];
+					float baked_y = ((c[4] * t + c[5]) * t + c[6]) * t + c[7];
+					error[v] = max(error[v], safety * hypot(baked_x - x(v, k0 + test), baked_y - y(v, k0 + test)));
+				}
+			}
+		}
+		return *max_element(error, error + num_vertices);
+	}
+
+	int bake_cycle(float tolerance, int max_segments) {
+		stop_simulation_thread();
+		baked_cycle.clear();
+		// the population kernel leaves loop-closure vertices where they are, there is no cycle to bake for them
+		if (!loop_closure_verts.empty() || num_vertices == 0 || !(tolerance > 0)) return 0;
+		// Three test angles per segment pick the resolution; the one that passes is checked again at 15, and what
+		// is recorded is that sampled maximum with a margin for the deviation between test angles. It remains an
+		// estimate, not a bound. Segments stay uniform (all halved together), so sampling needs no knot search.
+		const int coarse_samples = 4, dense_samples = 16;
+		const float safety = 1.25f;
+		vector<unsigned char> blob;
+		for (int num_segments = min(8, max(1, max_segments)); ; num_segments *= 2) {
+			float error = fit_baked_cycle(num_segments, coarse_samples, safety, blob);
+			if (!isfinite(error)) return 0; // some angle does not assemble
+			const bool last = 2 * num_segments > max_segments;
+			if (error <= tolerance || last) {
+				error = fit_baked_cycle(num_segments, dense_samples, safety, blob);
+				if (!isfinite(error)) return 0;
+			}
+			if (error <= tolerance || last) {
+				baked_cycle = move(blob);
+				return baked_cycle.size();
+			}
+		}
+	}
+
+	int get_baked_cycle(void* blob, int capacity) {
+		if (blob != nullptr && capacity >= (int)baked_cycle.size()) {
+			copy(baked_cycle.begin(), baked_cycle.end(), static_cast<unsigned char*>(blob));
+		}
+		return baked_cycle.size();
+	}
+
+	bool sample_baked_cycle(const void* blob, int size, float rotation, float* xy) {
+		const BakedCycleHeader* header = baked_cycle_header(blob, size);
+		if (header == nullptr) return false;
+		evaluate_baked_cycle(header, rotation, xy);
+		return true;
+	}
+
+	int get_baked_cycle_error(const void* blob, int size, float* error) {
+		const BakedCycleHeader* header = baked_cycle_header(blob, size);
+		if (header == nullptr) return -1;
+		if (error != nullptr) copy(baked_cycle_error(header), baked_cycle_error(header) + header->num_vertices, error);
+		return header->num_segments;
+	}
+
+	bool get_interpolated_positions(float alpha, bool resolve, float* xy) {
+		stop_simulation_thread();
+		if (num_stepped_states == 0 || stepped_states[1].x.size() != num_vertices) return false;
+		const SteppedState& latest = stepped_states[1];
+		if (num_stepped_states == 1) {
+			for (int v = 0; v < num_vertices; v++) {
+				xy[2 * v] = latest.x[v];
+				xy[2 * v + 1] = latest.y[v];
+			}
+			return true;
+		}
+		const SteppedState& earlier = stepped_states[0];
+		const float a = min(1.0f, max(0.0f, alpha));
+		// cubic Hermite basis, exact values and velocities at both ends
+		const float h00 = (1 + 2 * a) * (1 - a) * (1 - a), h10 = a * (1 - a) * (1 - a);
+		const float h01 = a * a * (3 - 2 * a), h11 = a * a * (a - 1);
+		const float dt = stepped_dt;
+
+		if (resolve) {
+			// only the motors are interpolated, the dyads are solved there, so no link changes its length.
+			// The loop-closure warm start is restored as well, so the next step() does not depend on this call.
+			vector<float> saved_rotations = current_motor_rotations();
+			const VectorXd saved_loop_closure_positions = loop_closure_positions;
+			int m = 0;
+			for (MotorizedVertex& m_vert : motorized_verts) {
+				float end = saved_rotations[m], start = end - stepped_advances[m];
+				m_vert.current_rotation = h00 * start + h10 * dt * earlier.speeds[m] + h01 * end + h11 * dt * latest.speeds[m];
+				m++;
+			}
+			frame_x.resize(num_vertices);
+			frame_y.resize(num_vertices);
+			simulate_frame(frame_x.data(), frame_y.data(), nullptr, false);
+			m = 0;
+			for (MotorizedVertex& m_vert : motorized_verts) {
+				m_vert.current_rotation = saved_rotations[m++];
+			}
+			loop_closure_positions = saved_loop_closure_positions;
+			for (int v = 0; v < num_vertices; v++) {
+				xy[2 * v] = frame_x[v];
+				xy[2 * v + 1] = frame_y[v];
+			}
+			return true;
+		}
+
+		PopulationArray x(num_vertices, 2), y(num_vertices, 2), vx, vy, latest_vx, latest_vy;
+		x.col(0) = Map<const VectorXf>(earlier.x.data(), num_vertices);
+		y.col(0) = Map<const VectorXf>(earlier.y.data(), num_vertices);
+		x.col(1) = Map<const VectorXf>(latest.x.data(), num_vertices);
+		y.col(1) = Map<const VectorXf>(latest.y.data(), num_vertices);
+		population_velocities(x, y, vx, vy, &earlier.speeds);
+		population_velocities(x, y, latest_vx, latest_vy, &latest.speeds);
+		for (int v : loop_closure_verts) { // no exact velocity known, the secant is the next best
+			vx(v, 0) = latest_vx(v, 1) = (x(v, 1) - x(v, 0)) / dt;
+			vy(v, 0) = latest_vy(v, 1) = (y(v, 1) - y(v, 0)) / dt;
+		}
+		for (int v = 0; v < num_vertices; v++) {
+			xy[2 * v] = h00 * x(v, 0) + h10 * dt * vx(v, 0) + h01 * x(v, 1) + h11 * dt * latest_vx(v, 1);
+			xy[2 * v + 1] = h00 * y(v, 0) + h10 * dt * vy(v, 0) + h01 * y(v, 1) + h11 * dt * latest_vy(v, 1);
+		}
+		return true;
+	}
+
+	int get_transmission_profile(float from, float to, int num_samples, int output_vertex, int input_vertex,
+		float* transmission_angles, float* mechanical_advantage)
+	{
+		stop_simulation_thread();
+		const int num_dynamic = dynamic_verts.size();
+		if (mechanical_advantage != nullptr && (output_vertex < 0 || output_vertex >= num_vertices
+			|| input_vertex < 0 || input_vertex >= num_vertices)) {
+			return -1;
+		}
+		if (num_samples <= 0) return num_dynamic;
+		PopulationArray edge_lengths, offsets;
+		rotation_sweep(from, to, num_samples, edge_lengths, offsets);
+		const vector<float> rotations(motorized_verts.size(), 0);
+
+		const int num_chunks = (num_samples + population_chunk_size - 1) / population_chunk_size;
+		parallel_for(num_chunks, [&](int c) {
+			int begin = c * population_chunk_size;
+			int count = min(population_chunk_size, num_samples - begin);
+			PopulationArray x, y, vx, vy;
+			simulate_population_chunk<float>(edge_lengths, PopulationArray(), rotations, begin, count, x, y, nullptr, &offsets);
+
+			if (transmission_angles != nullptr) {
+				int d = 0;
+				for (const DynamicVertex& d_vert : dynamic_verts) {
+					Array<float, 1, Dynamic> angle = d_vert.dependant_i >= 0
+						? Array<float, 1, Dynamic>(transmission_cosine(x, y, d_vert.index).max(-1.0f).min(1.0f).acos())
+						: Array<float, 1, Dynamic>::Constant(count, numeric_limits<float>::quiet_NaN()); // loop closure
+					for (int i = 0; i < count; i++) {
+						transmission_angles[(begin + i) * num_dynamic + d] = angle(i);
+					}
+					d++;
+				}
+			}
+			if (mechanical_advantage != nullptr) {
+				population_velocities(x, y, vx, vy);
+				Array<float, 1, Dynamic> input_speed = (vx.row(input_vertex).square() + vy.row(input_vertex).square()).sqrt();
+				Array<float, 1, Dynamic> output_speed = (vx.row(output_vertex).square() + vy.row(output_vertex).square()).sqrt();
+				Map<Array<float, 1, Dynamic>>(mechanical_advantage + begin, count) = output_speed / input_speed;
+			}
+		});
+		return num_dynamic;
+	}
+
+	// --- certified assembly ---
+
+	enum class Certainty { ASSEMBLES, FAILS, UNDECIDED };
+
+	// The simulation in interval arithmetic, for all motor rotations in `rotation` at once (motors turning
+	// together). A dyad closes for the whole interval if the enclosure of |ij|^2 lies within
+	// [(r_ik - r_jk)^2, (r_ik + r_jk)^2], and certainly fails if it lies outside. In between, the dyad continues
+	// with the part of |ij| for which it closes: if a later dyad certainly fails on that part, every rotation
+	// fails somewhere. Vertices solved by loop closure are not covered.
+	Certainty certify_rotation_interval(const Interval& rotation) {
+		vector<Interval> x(num_vertices), y(num_vertices);
+		for (const StaticVertex& s_vert : static_verts) {
+			x[s_vert.index] = s_vert.initial_x;
+			y[s_vert.index] = s_vert.initial_y;
+		}
+		for (const MotorizedVertex& m_vert : motorized_verts) {
+			Interval angle = rotation + Interval(m_vert.phase_offset);
+			x[m_vert.index] = x[m_vert.motor_vertex] + Interval(m_vert.distance_to_motor) * cos(angle);
+			y[m_vert.index] = y[m_vert.motor_vertex] + Interval(m_vert.distance_to_motor) * sin(angle);
+		}
+
+		Certainty result = Certainty::ASSEMBLES;
+		for (int index_k : ordered_dymanic_indices) {
+			const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[index_k]);
+			Interval dist_ik = d_vert->distance_to_i, dist_jk = d_vert->distance_to_j;
+			Interval ij_x = x[d_vert->dependant_j] - x[d_vert->dependant_i];
+			Interval ij_y = y[d_vert->dependant_j] - y[d_vert->dependant_i];
+			Interval dist_ij_squared = square(ij_x) + square(ij_y);
+
+			// enclosures of the exact bounds, so [lower.lo, upper.hi] is rounded outwards, [lower.hi, upper.lo] inwards
+			Interval lower = square(abs(dist_ik - dist_jk)), upper = square(dist_ik + dist_jk);
+			Interval closes(lower.lo, upper.hi), surely_closes(lower.hi, upper.lo);
+			if (!(dist_ij_squared.inside(surely_closes) && dist_ij_squared.lo > 0)) {
+				dist_ij_squared = intersect(dist_ij_squared, closes);
+				if (dist_ij_squared.is_empty()) return Certainty::FAILS;
+				result = Certainty::UNDECIDED;
+			}
+
+			Interval dist_ij = sqrt(dist_ij_squared);
+			Interval cos_phi = intersect((dist_ij_squared + square(dist_ik) - square(dist_jk)) / (Interval(2) * dist_ij * dist_ik),
+				Interval(-1, 1));
+			if (cos_phi.is_empty()) cos_phi = Interval(-1, 1);
+			Interval sin_phi = sqrt(Interval(1) - square(cos_phi));
+			Interval scale = dist_ik / dist_ij;
+			x[index_k] = x[d_vert->dependant_i] + scale * (cos_phi * ij_x - sin_phi * ij_y);
+			y[index_k] = y[d_vert->dependant_i] + scale * (sin_phi * ij_x + cos_phi * ij_y);
+		}
+		return result;
+	}
+
+	static const int certify_max_intervals = 1 << 20;
+
+	int certify_assembly(float from, float to, float resolution, float* fail_from, float* fail_to) {
+		stop_simulation_thread();
+		Interval failing = Interval::empty(), undecided = Interval::empty();
+		vector<Interval> pending = { Interval(from, to) }; // a stack, the leftmost interval on top
+		int evaluated = 0;
+		while (!pending.empty()) {
+			Interval rotation = pending.back(); pending.pop_back();
+			Certainty certainty = certify_rotation_interval(rotation);
+			if (certainty == Certainty::UNDECIDED && rotation.width() > resolution && ++evaluated < certify_max_intervals) {
+				pending.push_back(Interval(rotation.mid(), rotation.hi));
+				pending.push_back(Interval(rotation.lo, rotation.mid()));
+				continue;
+			}
+			if (certainty == Certainty::FAILS) {
+				if (failing.is_empty()) {
+					failing = rotation;
+				} else if (failing.hi == rotation.lo) {
+					failing.hi = rotation.hi; // the failing range continues
+				} else {
+					break; // the first failing range is complete
+				}
+			} else if (!failing.is_empty()) {
+				break;
+			} else if (certainty == Certainty::UNDECIDED && undecided.is_empty()) {
+				undecided = rotation;
+			}
+		}
+
+		const Interval& reported = !failing.is_empty() ? failing : undecided;
+		if (!reported.is_empty()) {
+			if (fail_from != nullptr) *fail_from = reported.lo;
+			if (fail_to != nullptr) *fail_to = reported.hi;
+		}
+		return !failing.is_empty() ? 0 : !undecided.is_empty() ? -1 : 1;
+	}
+
+
+	// DEPRECATED
+
+	// i, j, k according to Disney paper
+	// This assumes that i -> j -> k traverses the triangle counter-clockwise.
+	void symbolic_kinematic(
+		float* i_array, float* j_array,
+		float dist_ik, float dist_jk,
+		float* output_array
+	) {
+		Vector2f i(i_array[0], i_array[1]);
+		Vector2f j(j_array[0], j_array[1]);
+		float dist_ij = (i - j).norm();
+		float phi = acos(
+			(dist_ij * dist_ij + dist_ik * dist_ik - dist_jk * dist_jk)
+			/ (2 * dist_ij * dist_ik)
+		);
+
+		Rotation2D phi_rotation(phi);
+		Vector2f k = phi_rotation.toRotationMatrix() * (dist_ik * (j - i) / (j - i).norm()) + i;
+		output_array[0] = k.x(); output_array[1] = k.y();
+	}
+
+
+	dual get_edge_length_gardient(const VectorXdual& edge_lengths, const int vert_index, const Vector2dual& target_pos) {
 		
-		VectorXd edge_lengths = VectorXd(edges.size());
+		// Step 1: simulate all the positions
+		Matrix<dual, 2, Dynamic> positions;
+		simulate_for_edge_lengths(edge_lengths, current_motor_rotations(), positions);
+		
+		// Step 2: check current error
+		Vector2dual current_position_of_vertex(positions(0, vert_index), positions(1, vert_index));
+		dual error = dual(); error = Vector2dual(current_position_of_vertex - target_pos).norm();
+		return error;
+	}
+
+
+	void get_edge_length_gradients_for_target_position(
+		int vertex_index, float x, float y,
+		float* first_end, float* second_end, float* gradient_for_edge)
+	{
+		stop_simulation_thread();
+		
+		VectorXdual edge_lengths = VectorXdual(edges.size());
 		for (int i = 0; i < edges.size(); i++) {
-			Vector2d v1(all_verts[edges[i].first]->initial_x, all_verts[edges[i].first]->initial_y);
-			Vector2d v2(all_verts[edges[i].second]->initial_x, all_verts[edges[i].second]->initial_y);
+			Vector2f v1(all_verts[edges[i].first]->initial_x, all_verts[edges[i].first]->initial_y);
+			Vector2f v2(all_verts[edges[i].second]->initial_x, all_verts[edges[i].second]->initial_y);
 			edge_lengths(i) = (v1 - v2).norm();
 		}
-		for (auto d = dynamic_verts.begin(); d != dynamic_verts.end(); d++) { // ugly solution to get up-to-date lengths
-			for (int i = 0; i < edges.size(); i++) {
-				if (edges[i].first == d->index && edges[i].second == d->dependant_i || edges[i].second == d->index && edges[i].first == d->dependant_i) {
-					edge_lengths[i] = d->distance_to_i;
+
+		dual magnitude;
+		VectorXd g = gradient(
+			get_edge_length_gardient,
+			wrt(edge_lengths),
+			at(edge_lengths, vertex_index, Vector2dual(x, y)),
+			magnitude);
+
+		for (int i = 0; i < edges.size(); i++) {
+			first_end[i] = edges[i].first;
+			second_end[i] = edges[i].second;
+			gradient_for_edge[i] = g(i);
+		}
+
+	}
+
+
+	// --- optimization ---
+
+	struct grad_and_objective { VectorXd grad; double objective; };
+	grad_and_objective gradient_and_objective_for_target_position(
+		const VectorXd& input_edge_lengths,
+		int vertex_index, float x, float y)
+	{
+		VectorXdual edge_lengths = VectorXdual(input_edge_lengths.size());
+		for (int i = 0; i < input_edge_lengths.size(); i++) {
+			edge_lengths(i) = input_edge_lengths(i);
+		}
+
+		dual magnitude;
+		VectorXd g = gradient(
+			get_edge_length_gardient,
+			wrt(edge_lengths),
+			at(edge_lengths, vertex_index, Vector2dual(x, y)),
+			magnitude);
+
+		VectorXd grad = VectorXd(input_edge_lengths.size());
+		for (int i = 0; i < g.size(); i++) {
+			grad(i) = - g(i);
+		}
+		grad_and_objective ret;
+		ret.grad = grad;
+		ret.objective = magnitude.val;
+		return ret;
+	}
+
+	template<typename T> class EdgeLengthMinimizer : public Problem<T> {
+	public:
+		using typename Problem<T>::TVector;
+
+		int target_vert = 0;
+		Vector2d target_position;
+		T infeasible_penalty = 1e10;
+		bool parallel_batches = true; // false while the solver itself runs on a parallel_for worker
+
+		// best design visited by the solver so far, see callback()
+		TVector best_x;
+		T best_value = numeric_limits<T>::infinity();
+
+		void set_target(int vertex_index, float target_x, float target_y) {
+			target_vert = vertex_index;
+			target_position = Vector2d(target_x, target_y);
+		}
+
+
+		// objective function (plain simulation, no need to differentiate here)
+		T value(const TVector& x) {
+			Matrix<T, 2, Dynamic> positions;
+			simulate_for_edge_lengths<T>(x, current_motor_rotations(), positions);
+			T error = (Matrix<T, 2, 1>(positions.col(target_vert)) - target_position.cast<T>()).norm();
+			// designs that do not assemble get a large finite penalty, so that line searches back off
+			// instead of walking into NaN
+			return isfinite(error) ? error : infeasible_penalty;
+		}
+
+		// optional override of gradient (we calculate it ourselves)
+		void gradient(const TVector& x, TVector& grad) {
+			auto [gradients, obj] = gradient_and_objective_for_target_position(x, target_vert, target_position.x(), target_position.y());
+			for (int i = 0; i < gradients.size(); i++) {
+				// gradient_and_objective_for_target_position returns the descent direction
+				grad[i] = isfinite(gradients(i)) ? -gradients(i) : 0;
+			}
+		}
+
+		// whole populations (one design per column) are simulated in one batched call, in the same
+		// precision as value(), so that line searches can compare both
+		void batchValue(const typename Problem<T>::MatrixType& x, Matrix<T, Dynamic, 1>& values) {
+			PopulationArrayOf<T> edge_lengths = x;
+			PopulationArrayOf<T> positions_x, positions_y;
+			simulate_population(edge_lengths, PopulationArrayOf<T>(), current_motor_rotations(), positions_x, positions_y,
+				parallel_batches);
+
+			Array<T, 1, Dynamic> error = (
+				(positions_x.row(target_vert) - T(target_position.x())).square()
+				+ (positions_y.row(target_vert) - T(target_position.y())).square()).sqrt();
+			vector<bool> active = active_edge_mask();
+			values.resize(x.cols());
+			for (int c = 0; c < x.cols(); c++) {
+				bool is_feasible = isfinite(error(c));
+				for (int e = 0; e < active.size() && is_feasible; e++) {
+					is_feasible = !active[e] || edge_lengths(e, c) > 0;
+				}
+				values(c) = is_feasible ? T(error(c)) : infeasible_penalty;
+			}
+		}
+
+		// line search solvers do not know about infeasible designs and may still accept such a step,
+		// so track the best iterate and stop once the solver has left the feasible region
+		bool callback(const Criteria<T>&, const TVector& x) {
+			T current_value = value(x);
+			if (current_value < best_value) {
+				best_value = current_value;
+				best_x = x;
+			}
+			return current_value < infeasible_penalty;
+		}
+	};
+
+
+	// --- multi-start optimization ---
+
+	struct MultiStartResult { VectorXd edge_lengths; double error; };
+
+	// Latin hypercube around the current design: every active edge is split into num_starts strata
+	// of +-spread (relative), and each start picks a different stratum per edge.
+	vector<VectorXd> latin_hypercube_starts(const VectorXd& center, int num_starts, double spread, mt19937& gen) {
+		vector<bool> active = active_edge_mask();
+		vector<VectorXd> starts(num_starts, center);
+		uniform_real_distribution<double> jitter(0, 1);
+		vector<int> strata(num_starts);
+		for (int e = 0; e < center.size(); e++) {
+			if (!active[e]) continue;
+			for (int s = 0; s < num_starts; s++) strata[s] = s;
+			shuffle(strata.begin(), strata.end(), gen);
+			for (int s = 0; s < num_starts; s++) {
+				double u = (strata[s] + jitter(gen)) / num_starts; // in [0, 1)
+				starts[s](e) = center(e) * (1 + spread * (2 * u - 1));
+			}
+		}
+		return starts;
+	}
+
+	// runs the edge length optimization from several perturbed starts in parallel (each line search
+	// simulates its batch on the worker of its start) and returns the distinct converged designs, best first
+	vector<MultiStartResult> optimize_multi_start_for_target(int vertex_index, float x, float y,
+		int num_starts, double spread, int max_results)
+	{
+		mt19937 gen((random_device())());
+		VectorXd current = current_edge_lengths();
+		vector<VectorXd> starts = latin_hypercube_starts(current, num_starts - 1, spread, gen);
+		starts.push_back(current); // the current design always competes as well
+
+		vector<MultiStartResult> converged(starts.size());
+		parallel_for(starts.size(), [&](int s) {
+			EdgeLengthMinimizer<double> f;
+			f.set_target(vertex_index, x, y);
+			f.parallel_batches = false; // the starts already use every core
+			VectorXd edge_lengths = starts[s];
+			converged[s].error = f.value(edge_lengths);
+			if (!isfinite(converged[s].error)) return; // start does not assemble
+
+			// every line search step probes a whole bracket through the batched population kernel
+			LbfgsSolver<EdgeLengthMinimizer<double>, BatchedWolfe> solver;
+			Criteria<double> stop = Criteria<double>::defaults();
+			stop.iterations = 200;
+			solver.setStopCriteria(stop);
+			solver.minimize(f, edge_lengths);
+			if (f.value(edge_lengths) > f.best_value) edge_lengths = f.best_x;
+			converged[s].edge_lengths = edge_lengths;
+			converged[s].error = f.value(edge_lengths);
+		});
+
+		// drop failed runs, then cluster: keep a design only if it is not within tolerance of a better one
+		converged.erase(remove_if(converged.begin(), converged.end(), [](const MultiStartResult& r) {
+			return !isfinite(r.error) || r.edge_lengths.size() == 0 || !r.edge_lengths.allFinite();
+		}), converged.end());
+		sort(converged.begin(), converged.end(),
+			[](const MultiStartResult& a, const MultiStartResult& b) { return a.error < b.error; });
+		const double tolerance = 1e-3 * max(1.0, current.norm());
+		vector<MultiStartResult> distinct;
+		for (const MultiStartResult& r : converged) {
+			bool is_duplicate = false;
+			for (const MultiStartResult& d : distinct) {
+				if ((r.edge_lengths - d.edge_lengths).norm() < tolerance) {
+					is_duplicate = true;
+					break;
+				}
+			}
+			if (!is_duplicate) distinct.push_back(r);
+			if ((int)distinct.size() >= max_results) break;
+		}
+		return distinct;
+	}
+
+
+	// --- least squares fitting ---
+
+	// vertex_index should be at (x, y) while all motors are rotated to motor_rotation
+	struct TargetSample { int vertex_index; float x, y; float motor_rotation; };
+
+	// two residuals (x and y offset) per target sample
+	template<typename T>
+	Matrix<T, Dynamic, 1> get_target_residuals(const Matrix<T, Dynamic, 1>& edge_lengths, const vector<TargetSample>& targets) {
+		Matrix<T, Dynamic, 1> residuals(2 * targets.size());
+		Matrix<T, 2, Dynamic> positions;
+		vector<float> rotations(motorized_verts.size());
+		for (int t = 0; t < targets.size(); t++) {
+			// consecutive samples at the same rotation share one simulation
+			if (t == 0 || targets[t].motor_rotation != targets[t - 1].motor_rotation) {
+				fill(rotations.begin(), rotations.end(), targets[t].motor_rotation);
+				simulate_for_edge_lengths(edge_lengths, rotations, positions);
+			}
+			residuals(2 * t) = positions(0, targets[t].vertex_index) - targets[t].x;
+			residuals(2 * t + 1) = positions(1, targets[t].vertex_index) - targets[t].y;
+		}
+		return residuals;
+	}
+
+	VectorXdual get_target_residuals_dual(const VectorXdual& edge_lengths, const vector<TargetSample>& targets) {
+		return get_target_residuals<dual>(edge_lengths, targets);
+	}
+
+	template<typename T> class TargetFitMinimizer : public LeastSquaresProblem<T> {
+	public:
+		using typename LeastSquaresProblem<T>::TVector;
+		using typename LeastSquaresProblem<T>::TResiduals;
+		using typename LeastSquaresProblem<T>::TJacobian;
+
+		vector<TargetSample> targets;
+
+		void residuals(const TVector& x, TResiduals& r) {
+			r = get_target_residuals<T>(x, targets);
+		}
+
+		// positions-by-edges jacobian, one forward pass per edge
+		void jacobian(const TVector& x, TJacobian& jac) {
+			VectorXdual edge_lengths = VectorXdual(x.size());
+			for (int i = 0; i < x.size(); i++) {
+				edge_lengths(i) = x(i);
+			}
+			VectorXdual r;
+			jac = autodiff::forward::jacobian(get_target_residuals_dual, wrt(edge_lengths), at(edge_lengths, targets), r);
+		}
+	};
+
+
+	// --- parameter optimization ---
+
+	// position of vert_index as a function of the free variables of selection
+	template<typename T>
+	Matrix<T, 2, 1> get_parameter_position(const Matrix<T, Dynamic, 1>& free, const ParameterSelection& selection,
+		int vert_index)
+	{
+		Matrix<T, 2, Dynamic> positions;
+		simulate_for_parameters<T>(selection.expand(free), current_motor_rotations(), positions);
+		return positions.col(vert_index);
+	}
+
+	VectorXdual get_parameter_position_dual(const VectorXdual& free, const ParameterSelection& selection, int vert_index) {
+		return get_parameter_position<dual>(free, selection, vert_index);
+	}
+
+	// half the squared distance of vert_index to target_pos, as a function of the free variables of selection
+	// (squared, so that it stays smooth at the target and Newton steps make sense)
+	template<typename T>
+	T get_parameter_cost(const Matrix<T, Dynamic, 1>& free, const ParameterSelection& selection,
+		int vert_index, const Matrix<T, 2, 1>& target_pos)
+	{
+		return 0.5 * Matrix<T, 2, 1>(get_parameter_position<T>(free, selection, vert_index) - target_pos).squaredNorm();
+	}
+
+	dual get_parameter_cost_dual(const VectorXdual& free, const ParameterSelection& selection,
+		int vert_index, const Vector2dual& target_pos)
+	{
+		return get_parameter_cost<dual>(free, selection, vert_index, target_pos);
+	}
+
+	HigherOrderDual<2> get_parameter_cost_dual2nd(const VectorXdual2nd& free, const ParameterSelection& selection,
+		int vert_index, const Vector2dual2nd& target_pos)
+	{
+		return get_parameter_cost<HigherOrderDual<2>>(free, selection, vert_index, target_pos);
+	}
+
+	// Like EdgeLengthMinimizer, but over the selected parameters. Forward mode: the gradient costs one pass per
+	// variable (the hessian-vector product one second order pass per variable), whether it stands for an edge,
+	// an anchor, a radius or a phase, and tied parameters add up their contributions automatically.
+	template<typename T> class ParameterMinimizer : public Problem<T> {
+	public:
+		using typename Problem<T>::TVector;
+		using typename Problem<T>::THessian;
+
+		ParameterSelection selection;
+		int target_vert = 0;
+		Vector2d target_position;
+		T infeasible_penalty = 1e10;
+
+		TVector best_x;
+		T best_value = numeric_limits<T>::infinity();
+
+		T value(const TVector& x) {
+			T cost = get_parameter_cost<T>(x, selection, target_vert, target_position.cast<T>());
+			return isfinite(cost) ? cost : infeasible_penalty;
+		}
+
+		void gradient(const TVector& x, TVector& grad) {
+			VectorXdual free(x.size());
+			for (int i = 0; i < x.size(); i++) {
+				free(i) = x(i);
+			}
+			dual cost;
+			grad = autodiff::forward::gradient(get_parameter_cost_dual, wrt(free),
+				at(free, selection, target_vert, Vector2dual(target_position.x(), target_position.y())), cost);
+			for (int i = 0; i < grad.size(); i++) {
+				if (!isfinite(grad(i))) grad(i) = 0;
+			}
+		}
+
+		// H * v without forming H: one second order pass per variable i, seeded with e_i for the first
+		// and v for the second derivative, gives e_i^T H v
+		void hessianVectorProduct(const TVector& x, const TVector& v, TVector& hv) {
+			VectorXdual2nd free(x.size());
+			const Vector2dual2nd target(target_position.x(), target_position.y());
+			hv.resize(x.size());
+			for (int i = 0; i < x.size(); i++) {
+				for (int j = 0; j < x.size(); j++) {
+					free(j) = x(j);
+					free(j).val.grad = i == j ? 1 : 0;
+					free(j).grad.val = v(j);
+				}
+				HigherOrderDual<2> cost = get_parameter_cost<HigherOrderDual<2>>(free, selection, target_vert, target);
+				hv(i) = isfinite(cost.grad.grad) ? T(cost.grad.grad) : 0;
+			}
+		}
+
+		// exact hessian, one second order pass per pair of variables (small selections only)
+		void hessian(const TVector& x, THessian& hessian) {
+			VectorXdual2nd free = x.template cast<HigherOrderDual<2>>();
+			HigherOrderDual<2> cost;
+			VectorXd grad;
+			hessian = autodiff::forward::hessian(get_parameter_cost_dual2nd, wrt(free),
+				at(free, selection, target_vert, Vector2dual2nd(target_position.x(), target_position.y())), cost, grad);
+		}
+
+		// d(position of target_vert) / dx, 2 x number of variables
+		MatrixXd position_jacobian(const TVector& x) {
+			VectorXdual free = x.template cast<dual>();
+			VectorXdual position;
+			return autodiff::forward::jacobian(get_parameter_position_dual, wrt(free), at(free, selection, target_vert), position);
+		}
+
+		bool callback(const Criteria<T>&, const TVector& x) {
+			T current_value = value(x);
+			if (current_value < best_value) {
+				best_value = current_value;
+				best_x = x;
+			}
+			return current_value < infeasible_penalty;
+		}
+	};
+
+
+	// --- target dragging ---
+
+	// While a target is dragged, every frame continues from the previous frame's solution: the optimality
+	// condition grad(x, target) = 0 defines x*(target), and by the implicit function theorem
+	//   H dx = J^T dtarget   (H = hessian of the cost, J = position jacobian)
+	// predicts how x* moves with the target. A few Newton steps on grad = 0 then correct the prediction.
+	// H is singular along the directions that do not move the vertex, so both use its pseudo-inverse,
+	// which picks the smallest change of the linkage among all equally good ones.
+	static int drag_vertex = -1; // -1: no drag in progress
+	static Vector2d drag_target;
+	static const int drag_newton_steps = 3;
+
+	// minimum norm solution of H dx = rhs: directions with (nearly) zero curvature do not move the vertex
+	// and are left alone, negative curvature is flipped so that corrections never head for a maximum
+	bool solve_minimum_norm(const MatrixXd& hessian, const VectorXd& rhs, VectorXd& dx) {
+		if (!hessian.allFinite() || !rhs.allFinite()) return false;
+		SelfAdjointEigenSolver<MatrixXd> eigen(hessian);
+		if (eigen.info() != Success) return false;
+		const VectorXd& curvature = eigen.eigenvalues();
+		const double tolerance = 1e-6 * max(1.0, curvature.cwiseAbs().maxCoeff());
+		VectorXd projected = eigen.eigenvectors().transpose() * rhs;
+		for (int i = 0; i < projected.size(); i++) {
+			projected(i) = abs(curvature(i)) > tolerance ? projected(i) / abs(curvature(i)) : 0;
+		}
+		dx = eigen.eigenvectors() * projected;
+		return true;
+	}
+
+	// largest of step, step / 2, step / 4, ... that keeps the linkage assembled and does not increase the cost
+	bool damped_step(ParameterMinimizer<double>& f, VectorXd& x, const VectorXd& step, double& cost) {
+		for (double t = 1; t > 1e-3; t *= 0.5) {
+			const VectorXd x_new = x + t * step;
+			const double cost_new = f.value(x_new);
+			if (cost_new < f.infeasible_penalty && cost_new <= cost) {
+				x = x_new;
+				cost = cost_new;
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+	// --- assembly modes ---
+
+	// Every dyad can close on either side of the line through its two neighbours, giving 2^D assembly modes.
+	// Searching them for a target is a depth-first branch and bound over the dyads the target depends on,
+	// placed in order of dependence. Once some vertices of the chain are placed, the target vertex can be
+	// at most reach[v] (shortest path along the links) away from each of them, which bounds the distance
+	// any completion of the partial chain can achieve.
+	class AssemblyModeSearch {
+	public:
+		int target_vert;
+		Vector2d target_position;
+		vector<int> chain; // dynamic vertices the target depends on, in order of dependence
+		vector<int> others; // the remaining dynamic vertices, they cannot move the target
+		Matrix2Xd base_positions; // static and motorized vertices placed
+		VectorXd reach;
+
+		atomic<double> best_distance;
+		mutex best_mutex;
+		vector<char> best_flips; // per chain entry: 1 = the other side than currently set
+
+		AssemblyModeSearch(int vertex_index, const Vector2d& target) : target_vert(vertex_index), target_position(target) {
+			simulate_for_parameters<double>(current_parameters(), current_motor_rotations(), base_positions);
+			vector<bool> in_chain(num_vertices, false);
+			if (all_verts[vertex_index]->type == VertexType::DYNAMIC) in_chain[vertex_index] = true;
+			for (auto k = ordered_dymanic_indices.rbegin(); k != ordered_dymanic_indices.rend(); k++) {
+				if (!in_chain[*k]) continue;
+				const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[*k]);
+				in_chain[d_vert->dependant_i] = in_chain[d_vert->dependant_j] = true;
+			}
+			for (int index_k : ordered_dymanic_indices) {
+				(in_chain[index_k] ? chain : others).push_back(index_k);
+			}
+
+			// shortest link paths to the target vertex (Bellman-Ford, the linkages are small)
+			reach = VectorXd::Constant(num_vertices, numeric_limits<double>::infinity());
+			reach(vertex_index) = 0;
+			vector<tuple<int, int, double>> links;
+			for (const MotorizedVertex& m_vert : motorized_verts) {
+				links.emplace_back(m_vert.index, m_vert.motor_vertex, m_vert.distance_to_motor);
+			}
+			for (const DynamicVertex& d_vert : dynamic_verts) {
+				if (d_vert.dependant_i < 0) continue;
+				links.emplace_back(d_vert.index, d_vert.dependant_i, d_vert.distance_to_i);
+				links.emplace_back(d_vert.index, d_vert.dependant_j, d_vert.distance_to_j);
+			}
+			for (int round = 0; round < num_vertices; round++) {
+				for (const auto& link : links) {
+					int a = get<0>(link), b = get<1>(link);
+					double length = abs(get<2>(link));
+					reach(a) = min(reach(a), reach(b) + length);
+					reach(b) = min(reach(b), reach(a) + length);
+				}
+			}
+			best_distance = numeric_limits<double>::infinity();
+		}
+
+		// lower bound on the final distance contributed by one placed vertex
+		double bound(const Matrix2Xd& positions, int index) const {
+			if (!isfinite(reach(index))) return 0;
+			return max(0.0, (positions.col(index) - target_position).norm() - reach(index));
+		}
+
+		// places chain[depth] on side flip, false if it does not assemble
+		bool place(int depth, bool flip, Matrix2Xd& positions) const {
+			const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[chain[depth]]);
+			if (flip) {
+				place_dyad<double>(d_vert->index, d_vert->dependant_j, d_vert->dependant_i,
+					d_vert->distance_to_j, d_vert->distance_to_i, positions);
+			} else {
+				place_dyad<double>(d_vert->index, d_vert->dependant_i, d_vert->dependant_j,
+					d_vert->distance_to_i, d_vert->distance_to_j, positions);
+			}
+			return positions.col(d_vert->index).allFinite();
+		}
+
+		// every dyad outside the chain has to assemble as well (its own side does not matter for that)
+		bool others_assemble(Matrix2Xd positions) const {
+			for (int index_k : others) {
+				const DynamicVertex* d_vert = static_cast<const DynamicVertex*>(all_verts[index_k]);
+				place_dyad<double>(index_k, d_vert->dependant_i, d_vert->dependant_j,
+					d_vert->distance_to_i, d_vert->distance_to_j, positions);
+				if (!positions.col(index_k).allFinite()) return false;
+			}
+			return true;
+		}
+
+		void search(int depth, double lower_bound, Matrix2Xd& positions, vector<char>& flips) {
+			if (lower_bound >= best_distance) return;
+			if (depth == chain.size()) {
+				double distance = (positions.col(target_vert) - target_position).norm();
+				if (distance >= best_distance || !others_assemble(positions)) return;
+				lock_guard<mutex> lock(best_mutex);
+				if (distance < best_distance) {
+					best_distance = distance;
+					best_flips = flips;
+				}
+				return;
+			}
+			for (char flip = 0; flip < 2; flip++) {
+				// assembling does not depend on the side, only on the vertices before
+				if (!place(depth, flip, positions)) return;
+				flips[depth] = flip;
+				search(depth + 1, max(lower_bound, bound(positions, chain[depth])), positions, flips);
+			}
+		}
+
+		// splits the tree into 2^levels subtrees and searches them in parallel, all sharing best_distance
+		void run() {
+			Matrix2Xd positions = base_positions;
+			double lower_bound = 0;
+			for (int v = 0; v < num_vertices; v++) {
+				if (all_verts[v]->type != VertexType::DYNAMIC) lower_bound = max(lower_bound, bound(positions, v));
+			}
+			const int threads = max(1u, thread::hardware_concurrency());
+			int levels = 0;
+			while (levels < chain.size() && (1 << levels) < 4 * threads) levels++;
+			parallel_for(1 << levels, [&](int subtree) {
+				Matrix2Xd subtree_positions = base_positions;
+				vector<char> flips(chain.size(), 0);
+				double subtree_bound = lower_bound;
+				for (int depth = 0; depth < levels; depth++) {
+					flips[depth] = (subtree >> depth) & 1;
+					if (!place(depth, flips[depth], subtree_positions)) return;
+					subtree_bound = max(subtree_bound, bound(subtree_positions, chain[depth]));
+				}
+				search(levels, subtree_bound, subtree_positions, flips);
+			});
+		}
+	};
+
+
+	// --- multi-objective design exploration ---
+
+	// A design is all edge lengths followed by the anchor (static vertex) positions x0, y0, x1, y1, ...
+	// Objectives per full motor cycle, in this order:
+	//   stride length         x extent of the foot path                         (maximized)
+	//   flatness              y extent of the lower half of the foot path       (minimized)
+	//   peak joint velocity   fastest vertex, in length units per radian         (minimized)
+	//   min transmission angle  worst angle between the two links of any dyad  (maximized)
+	static const int num_cycle_objectives = 4;
+	// transmission angles must stay within [limit, pi - limit] at every sample, 0 = no limit
+	static float transmission_angle_limit = 0;
+
+	void set_transmission_angle_limit(float min_angle) {
+		stop_design_exploration();
+		transmission_angle_limit = min_angle;
+	}
+
+	// Evaluates designs (genes x candidates) over num_samples motor angles in [0, 2pi), all motors turning
+	// together. objectives are returned in the units above, violation counts the samples at which the
+	// design does not assemble or violates the transmission angle limit (plus one for every non-positive active edge).
+	void evaluate_cycle_objectives(const MatrixXd& designs, int foot_vertex, int num_samples,
+		MatrixXd& objectives, VectorXd& violation)
+	{
+		const int num_edges = edges.size();
+		const int population = designs.cols();
+		const PopulationArray edge_lengths = designs.topRows(num_edges).cast<float>().array();
+		const PopulationArray anchor_positions = designs.bottomRows(designs.rows() - num_edges).cast<float>().array();
+		const vector<bool> active = active_edge_mask();
+		const float step = 2 * EIGEN_PI / num_samples;
+		objectives.resize(num_cycle_objectives, population);
+		violation.resize(population);
+
+		const int num_chunks = (population + population_chunk_size - 1) / population_chunk_size;
+		parallel_for(num_chunks, [&](int c) {
+			using Row = Array<float, 1, Dynamic>;
+			const int begin = c * population_chunk_size;
+			const int count = min(population_chunk_size, population - begin);
+
+			Row min_x = Row::Constant(count, numeric_limits<float>::infinity()), max_x = -min_x;
+			Row peak_velocity = Row::Zero(count), max_cos_transmission = Row::Zero(count);
+			Row failed_samples = Row::Zero(count);
+			PopulationArray foot_y(num_samples, count);
+			PopulationArray x, y, margin, first_x, first_y, previous_x, previous_y;
+			vector<float> rotations(motorized_verts.size());
+
+			for (int s = 0; s <= num_samples; s++) {
+				if (s < num_samples) {
+					fill(rotations.begin(), rotations.end(), s * step);
+					simulate_population_chunk(edge_lengths, anchor_positions, rotations, begin, count, x, y, &margin);
+				} else { // closes the cycle for the velocity
+					x = first_x;
+					y = first_y;
+				}
+
+				if (s > 0) {
+					Row speed = (((x - previous_x).square() + (y - previous_y).square()).sqrt() / step).colwise().maxCoeff();
+					peak_velocity = peak_velocity.max(speed);
+				} else {
+					first_x = x;
+					first_y = y;
+				}
+				previous_x = x;
+				previous_y = y;
+				if (s == num_samples) break;
+
+				failed_samples += (margin.colwise().minCoeff() < 0).cast<float>();
+
+				min_x = min_x.min(x.row(foot_vertex));
+				max_x = max_x.max(x.row(foot_vertex));
+				foot_y.row(s) = y.row(foot_vertex);
+
+				// transmission angle of dyad i-k-j, the worst dyad of this sample
+				Row sample_cos_transmission = Row::Zero(count);
+				for (int index_k : ordered_dymanic_indices) {
+					sample_cos_transmission = sample_cos_transmission.max(transmission_cosine(x, y, index_k).abs());
+				}
+				max_cos_transmission = max_cos_transmission.max(sample_cos_transmission);
+				if (transmission_angle_limit > 0) {
+					failed_samples += (sample_cos_transmission > cos(transmission_angle_limit)).cast<float>();
+				}
+			}
+
+			const int lower_half = max(1, num_samples / 2);
+			vector<float> sample_y(num_samples);
+			for (int i = 0; i < count; i++) {
+				int candidate = begin + i;
+				float failed = failed_samples(i);
+				for (int e = 0; e < num_edges; e++) {
+					if (active[e] && !(edge_lengths(e, candidate) > 0)) failed++;
+				}
+				violation(candidate) = failed;
+				if (failed > 0) {
+					objectives.col(candidate).setZero();
+					continue;
 				}
-				if (edges[i].first == d->index && edges[i].second == d->dependant_j || edges[i].second == d->index && edges[i].first == d->dependant_j) {
-					edge_lengths[i] = d->distance_to_j;
+
+				for (int s = 0; s < num_samples; s++) sample_y[s] = foot_y(s, i);
+				nth_element(sample_y.begin(), sample_y.begin() + lower_half - 1, sample_y.end());
+				float lowest = *min_element(sample_y.begin(), sample_y.begin() + lower_half);
+				float highest = *max_element(sample_y.begin(), sample_y.begin() + lower_half);
+
+				objectives(0, candidate) = max_x(i) - min_x(i);
+				objectives(1, candidate) = highest - lowest;
+				objectives(2, candidate) = peak_velocity(i);
+				objectives(3, candidate) = acos(min(1.0f, max_cos_transmission(i)));
+			}
+		});
+	}
+
+	// exploration runs on its own thread and publishes its current front after every generation.
+	// The linkage must not be modified while it runs (init() stops it).
+	static thread exploration_thread;
+	static atomic<bool> exploration_stop_requested(false);
+	static mutex exploration_mutex; // guards everything below
+	static MatrixXf pareto_designs, pareto_objectives;
+	static int exploration_generation = 0;
+
+	void run_design_exploration(Nsga2 nsga, VectorXd seed) {
+		nsga.initialize(seed);
+		while (!exploration_stop_requested) {
+			MatrixXd designs, objectives;
+			nsga.get_front(designs, objectives);
+			{
+				lock_guard<mutex> lock(exploration_mutex);
+				pareto_designs = designs.cast<float>();
+				pareto_objectives = objectives.cast<float>();
+				pareto_objectives.row(0) *= -1; // back from minimization to natural units
+				pareto_objectives.row(3) *= -1;
+				exploration_generation = nsga.generation;
+			}
+			nsga.step();
+		}
+	}
+
+
+	// --- single-objective cycle optimization ---
+
+	// Weighted sum of the cycle objectives (stride and transmission angle count negatively, so that
+	// positive weights always mean "better"), over the same designs as the exploration above.
+	class CycleObjectiveProblem : public Problem<double> {
+	public:
+		int foot_vertex = 0;
+		int num_samples = 64;
+		Vector4d weights = Vector4d::Ones();
+		double infeasible_penalty = 1e10;
+
+		// best truly evaluated design, CMA-ES itself only returns the mean
+		VectorXd best_x;
+		double best_value = numeric_limits<double>::infinity();
+		int evaluations = 0;
+
+		double value(const TVector& x) {
+			VectorXd values;
+			batchValue(x, values);
+			return values(0);
+		}
+
+		void batchValue(const MatrixType& x, VectorXd& values) {
+			MatrixXd objectives;
+			VectorXd violation;
+			evaluate_cycle_objectives(x, foot_vertex, num_samples, objectives, violation);
+			evaluations += x.cols();
+			values.resize(x.cols());
+			for (int c = 0; c < x.cols(); c++) {
+				values(c) = violation(c) > 0 ? infeasible_penalty
+					: -weights(0) * objectives(0, c) + weights(1) * objectives(1, c)
+					+ weights(2) * objectives(2, c) - weights(3) * objectives(3, c);
+				if (values(c) < best_value) {
+					best_value = values(c);
+					best_x = x.col(c);
 				}
 			}
 		}
+	};
+
+
+	bool optimize_for_target_location(int vertex_index, float x, float y) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		// ---------- DEBUG -------------
+		ofstream out("unity_symbo_dll_cout.txt"); cout.rdbuf(out.rdbuf());
+		ofstream err("unity_symbo_dll_cerr.txt"); cerr.rdbuf(err.rdbuf());
+		cout << "writing to cout" << endl;
+		cerr << "writing to cerr" << endl;
+		// ---------- DEBUG -------------
+		
+		VectorXd edge_lengths = current_edge_lengths();
 		
 		/*EdgeLengthMinimizer<double> f;
 		GradientDescentSolver<EdgeLengthMinimizer<double>> solver;
@@ -453,19 +2405,587 @@ namespace Symbo {
 		
 		auto [grad, obj] = gradient_and_objective_for_target_position(edge_lengths, vertex_index, x, y);
 
-		for (auto d = dynamic_verts.begin(); d != dynamic_verts.end(); d++) {
-			for (int i = 0; i < edges.size(); i++) {
-				if ((edges[i].first == d->index && edges[i].second == d->dependant_i)
-					|| edges[i].second == d->index && edges[i].first == d->dependant_i) {
-					d->distance_to_i = edge_lengths(i) + grad(i) * 0.01 * min(obj, 1.0);
-				}
-				if ((edges[i].first == d->index && edges[i].second == d->dependant_j)
-					|| edges[i].second == d->index && edges[i].first == d->dependant_j) {
-					d->distance_to_j = edge_lengths(i) + grad(i) * 0.01 * min(obj, 1.0);
-				}
+		apply_edge_lengths(edge_lengths + grad * 0.01 * min(obj, 1.0));
+		return true;
+	}
+
+
+	bool fit_target_locations(const int* vertex_indices, const float* target_xy, const float* motor_rotations, int num_targets) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		if (num_targets <= 0 || vertex_indices == nullptr || target_xy == nullptr || motor_rotations == nullptr) return false;
+		TargetFitMinimizer<double> f;
+		for (int t = 0; t < num_targets; t++) {
+			if (vertex_indices[t] < 0 || vertex_indices[t] >= num_vertices) return false;
+			f.targets.push_back({ vertex_indices[t], target_xy[2 * t], target_xy[2 * t + 1], motor_rotations[t] });
+		}
+		// group by rotation, so that samples at the same crank angle share a simulation
+		stable_sort(f.targets.begin(), f.targets.end(),
+			[](const TargetSample& a, const TargetSample& b) { return a.motor_rotation < b.motor_rotation; });
+
+		VectorXd edge_lengths = current_edge_lengths();
+		const double initial_error = f.value(edge_lengths); // NaN if some sample does not assemble
+		LevenbergMarquardtSolver<TargetFitMinimizer<double>> solver;
+		solver.minimize(f, edge_lengths);
+
+		// like optimize_global_for_target_location, only take the result if it actually is an improvement
+		const double error = edge_lengths.allFinite() ? f.value(edge_lengths) : numeric_limits<double>::quiet_NaN();
+		if (!isfinite(error) || (isfinite(initial_error) && !(error < initial_error))) return false;
+		apply_edge_lengths(edge_lengths);
+		return true;
+	}
+
+
+	int optimize_multi_start(int vertex_index, float x, float y, int num_starts, float spread, int max_results,
+		float* edge_length_output, float* error_output)
+	{
+		stop_simulation_thread();
+		stop_design_exploration();
+		if (max_results < 1) return 0; // nothing fits into the output
+		vector<MultiStartResult> results = optimize_multi_start_for_target(vertex_index, x, y,
+			max(1, num_starts), spread, max_results);
+		for (int r = 0; r < results.size(); r++) {
+			for (int e = 0; e < edges.size(); e++) {
+				edge_length_output[r * edges.size() + e] = results[r].edge_lengths(e);
+			}
+			error_output[r] = results[r].error;
+		}
+		return results.size();
+	}
+
+	void set_edge_lengths(const float* edge_lengths) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		VectorXd lengths(edges.size());
+		for (int e = 0; e < edges.size(); e++) {
+			lengths(e) = edge_lengths[e];
+		}
+		apply_edge_lengths(lengths);
+	}
+
+	bool optimize_global_for_target_location(int vertex_index, float x, float y, float step_size, int max_generations) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		EdgeLengthMinimizer<double> f;
+		f.set_target(vertex_index, x, y);
+		VectorXd edge_lengths = current_edge_lengths();
+		const double initial_error = f.value(edge_lengths);
+
+		CMAesSolver<EdgeLengthMinimizer<double>> solver;
+		Criteria<double> stop = Criteria<double>::defaults();
+		stop.iterations = max_generations;
+		stop.gradNorm = 0;
+		stop.xDelta = 1e-7;
+		stop.fDelta = 1e-9;
+		stop.condition = 1e14;
+		solver.setStopCriteria(stop);
+		solver.setStepSize(step_size);
+		solver.minimize(f, edge_lengths);
+
+		// CMA-ES returns the distribution mean, only take it if it actually is an improvement
+		if (!edge_lengths.allFinite() || !(f.value(edge_lengths) < initial_error)) return false;
+		apply_edge_lengths(edge_lengths);
+		return true;
+	}
+
+
+	int get_parameter_count() {
+		return parameter_count();
+	}
+
+	void get_parameters(float* parameters) {
+		stop_simulation_thread();
+		VectorXd current = current_parameters();
+		for (int p = 0; p < current.size(); p++) {
+			parameters[p] = current(p);
+		}
+	}
+
+	void set_parameters(const float* parameters) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		VectorXd values(parameter_count());
+		for (int p = 0; p < values.size(); p++) {
+			values(p) = parameters[p];
+		}
+		apply_parameters(values);
+	}
+
+	int select_free_parameters(const int* free_index, const float* scale) {
+		free_parameter_index.clear();
+		free_parameter_scale.clear();
+		if (free_index == nullptr) { // back to the default selection
+			return get_free_parameter_selection().num_free;
+		}
+		for (int p = 0; p < parameter_count(); p++) {
+			free_parameter_index.push_back(max(-1, free_index[p]));
+			free_parameter_scale.push_back(scale != nullptr ? scale[p] : 1);
+		}
+		return get_free_parameter_selection().num_free;
+	}
+
+	float get_parameter_gradients_for_target_position(int vertex_index, float x, float y, float* gradient) {
+		stop_simulation_thread();
+		ParameterMinimizer<double> f;
+		f.selection = get_free_parameter_selection();
+		f.target_vert = vertex_index;
+		f.target_position = Vector2d(x, y);
+		VectorXd free = f.selection.contract(f.selection.base);
+		VectorXd grad;
+		f.gradient(free, grad);
+		// the minimizer works on half the squared distance, d(distance) = d(cost) / distance
+		double distance = sqrt(2 * f.value(free));
+		for (int i = 0; i < grad.size(); i++) {
+			gradient[i] = distance > 0 ? grad(i) / distance : 0;
+		}
+		return distance;
+	}
+
+	bool optimize_parameters_for_target_location(int vertex_index, float x, float y) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		ParameterMinimizer<double> f;
+		f.selection = get_free_parameter_selection();
+		f.target_vert = vertex_index;
+		f.target_position = Vector2d(x, y);
+		if (f.selection.num_free == 0) return false;
+
+		VectorXd free = f.selection.contract(f.selection.base);
+		const double initial_cost = f.value(free);
+		// trust region Newton copes with targets close to the edge of the reachable region, where
+		// line search methods crawl along the singularity
+		TrustRegionNewtonCGSolver<ParameterMinimizer<double>> solver;
+		solver.setInitialRadius(0.1 * max(1.0, free.norm()));
+		solver.setInfeasibleValue(f.infeasible_penalty);
+		solver.minimize(f, free);
+		if (!(f.value(free) <= f.best_value)) free = f.best_x;
+
+		if (!free.allFinite() || !(f.value(free) < initial_cost)) return false;
+		apply_parameters(f.selection.expand<double>(free));
+		return true;
+	}
+
+	bool drag_target_location(int vertex_index, float x, float y) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		ParameterMinimizer<double> f;
+		f.selection = get_free_parameter_selection();
+		f.target_vert = vertex_index;
+		if (f.selection.num_free == 0) return false;
+
+		VectorXd free = f.selection.contract(f.selection.base);
+		const Vector2d target(x, y);
+		if (drag_vertex != vertex_index) { // drag starts where the vertex currently is
+			drag_target = get_parameter_position<double>(free, f.selection, vertex_index);
+			if (!drag_target.allFinite()) drag_target = target;
+			drag_vertex = vertex_index;
+		}
+
+		// predictor: tangent of x*(target) at the previous target
+		f.target_position = drag_target;
+		MatrixXd hessian;
+		f.hessian(free, hessian);
+		VectorXd tangent;
+		const bool predicted = solve_minimum_norm(hessian,
+			f.position_jacobian(free).transpose() * (target - drag_target), tangent);
+		f.target_position = target;
+		double cost = f.value(free);
+		if (predicted) damped_step(f, free, tangent, cost);
+
+		// corrector: Newton on grad(x, target) = 0
+		VectorXd grad, step;
+		for (int i = 0; i < drag_newton_steps; i++) {
+			f.gradient(free, grad);
+			if (grad.lpNorm<Infinity>() < 1e-10) break;
+			f.hessian(free, hessian);
+			if (!solve_minimum_norm(hessian, -grad, step) || !damped_step(f, free, step, cost)) break;
+		}
+
+		drag_target = target;
+		if (!(cost < f.infeasible_penalty)) return false;
+		apply_parameters(f.selection.expand<double>(free));
+		return true;
+	}
+
+	void end_target_drag() {
+		drag_vertex = -1;
+	}
+
+	int get_assembly_mode(int* mirrored) {
+		stop_simulation_thread();
+		int d = 0;
+		for (const DynamicVertex& d_vert : dynamic_verts) {
+			mirrored[d++] = d_vert.mirrored ? 1 : 0;
+		}
+		return d;
+	}
+
+	void set_assembly_mode(const int* mirrored) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		int d = 0;
+		for (DynamicVertex& d_vert : dynamic_verts) {
+			if (d_vert.dependant_i >= 0 && (mirrored[d] != 0) != d_vert.mirrored) {
+				d_vert.swap_dependants();
+				d_vert.mirrored = !d_vert.mirrored;
+			}
+			d++;
+		}
+	}
+
+	bool optimize_assembly_mode_for_target_location(int vertex_index, float x, float y, float* distance) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		AssemblyModeSearch search(vertex_index, Vector2d(x, y));
+		search.run();
+		if (distance != nullptr) *distance = search.best_distance;
+		if (!isfinite(search.best_distance)) return false;
+		for (int c = 0; c < search.chain.size(); c++) {
+			if (!search.best_flips[c]) continue;
+			DynamicVertex* d_vert = static_cast<DynamicVertex*>(all_verts[search.chain[c]]);
+			d_vert->swap_dependants();
+			d_vert->mirrored = !d_vert->mirrored;
+		}
+		return true;
+	}
+
+
+	int get_design_size() {
+		return edges.size() + 2 * static_verts.size();
+	}
+
+	void set_anchor_positions(const float* xy) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		int s = 0;
+		for (StaticVertex& s_vert : static_verts) {
+			s_vert.initial_x = xy[2 * s];
+			s_vert.initial_y = xy[2 * s + 1];
+			s++;
+		}
+	}
+
+	bool optimize_cycle_objectives(int foot_vertex, int num_samples, const float* weights, float step_size,
+		int max_generations, bool use_surrogate, int* true_evaluations, int* saved_evaluations)
+	{
+		stop_simulation_thread();
+		stop_design_exploration();
+		if (true_evaluations != nullptr) *true_evaluations = 0;
+		if (saved_evaluations != nullptr) *saved_evaluations = 0;
+		if (weights == nullptr || foot_vertex < 0 || foot_vertex >= num_vertices || num_samples < 2) return false;
+
+		CycleObjectiveProblem f;
+		f.foot_vertex = foot_vertex;
+		f.num_samples = num_samples;
+		f.weights = Vector4d(weights[0], weights[1], weights[2], weights[3]);
+		VectorXd parameters = current_parameters();
+		VectorXd design = parameters.head(get_design_size());
+		const double initial_value = f.value(design);
+
+		Criteria<double> stop = Criteria<double>::defaults();
+		stop.iterations = max_generations;
+		stop.gradNorm = 0;
+		stop.xDelta = 1e-7;
+		stop.fDelta = 0;
+		stop.condition = 1e14;
+		if (use_surrogate) {
+			// only the better half of each generation (the parents) is simulated for real
+			SurrogateProblem<CycleObjectiveProblem> surrogate(f);
+			surrogate.setIgnoreAbove(f.infeasible_penalty / 2);
+			CMAesSolver<SurrogateProblem<CycleObjectiveProblem>> solver;
+			solver.setStopCriteria(stop);
+			solver.setStepSize(step_size);
+			solver.minimize(surrogate, design);
+			if (saved_evaluations != nullptr) *saved_evaluations = surrogate.savedEvaluations();
+		} else {
+			CMAesSolver<CycleObjectiveProblem> solver;
+			solver.setStopCriteria(stop);
+			solver.setStepSize(step_size);
+			solver.minimize(f, design);
+		}
+		if (true_evaluations != nullptr) *true_evaluations = f.evaluations;
+
+		if (!(f.best_value < initial_value)) return false;
+		parameters.head(f.best_x.size()) = f.best_x;
+		int m = 0;
+		for (const MotorizedVertex& m_vert : motorized_verts) { // cranks with an edge are part of the design
+			if (m_vert.edge_to_motor >= 0) parameters(radius_parameter(m)) = f.best_x(m_vert.edge_to_motor);
+			m++;
+		}
+		apply_parameters(parameters);
+		return true;
+	}
+
+	bool start_design_exploration(int foot_vertex, int num_samples, int population_size, float edge_spread, float anchor_spread) {
+		stop_simulation_thread(); // both read the linkage, only one may run at a time
+		stop_design_exploration();
+		if (foot_vertex < 0 || foot_vertex >= num_vertices || num_samples < 2 || population_size < 4) return false;
+
+		// the current design seeds the search, bounds are relative for edges and absolute for anchors
+		const int num_edges = edges.size();
+		VectorXd seed(get_design_size());
+		seed.head(num_edges) = current_edge_lengths();
+		int s = num_edges;
+		for (const StaticVertex& s_vert : static_verts) {
+			seed(s++) = s_vert.initial_x;
+			seed(s++) = s_vert.initial_y;
+		}
+		VectorXd spread(seed.size());
+		vector<bool> active = active_edge_mask();
+		for (int e = 0; e < num_edges; e++) {
+			spread(e) = active[e] ? edge_spread * seed(e) : 0; // inactive edges have no effect, keep them as they are
+		}
+		spread.tail(seed.size() - num_edges).setConstant(anchor_spread);
+
+		Nsga2 nsga(num_cycle_objectives, [foot_vertex, num_samples](const MatrixXd& designs, MatrixXd& objectives, VectorXd& violation) {
+			evaluate_cycle_objectives(designs, foot_vertex, num_samples, objectives, violation);
+			objectives.row(0) *= -1; // longer stride
+			objectives.row(3) *= -1; // larger transmission angle
+		});
+		nsga.lower_bound = seed - spread;
+		nsga.upper_bound = seed + spread;
+		nsga.population_size = population_size;
+
+		{
+			lock_guard<mutex> lock(exploration_mutex);
+			pareto_designs.resize(0, 0);
+			pareto_objectives.resize(0, 0);
+			exploration_generation = 0;
+		}
+		exploration_stop_requested = false;
+		exploration_thread = thread(run_design_exploration, nsga, seed);
+		return true;
+	}
+
+	void stop_design_exploration() {
+		exploration_stop_requested = true;
+		if (exploration_thread.joinable()) exploration_thread.join();
+	}
+
+	int get_pareto_front(float* designs, float* objectives, int max_designs, int* generation) {
+		lock_guard<mutex> lock(exploration_mutex);
+		int count = min<int>(max_designs, pareto_designs.cols());
+		// column-major, so every design / objective vector is contiguous
+		if (designs != nullptr) copy(pareto_designs.data(), pareto_designs.data() + count * pareto_designs.rows(), designs);
+		if (objectives != nullptr) {
+			copy(pareto_objectives.data(), pareto_objectives.data() + count * pareto_objectives.rows(), objectives);
+		}
+		if (generation != nullptr) *generation = exploration_generation;
+		return count;
+	}
+
+
+	// --- background simulation ---
+
+	// The simulation thread owns the linkage while it runs: it steps the motors at a fixed rate, applies the
+	// commands the main thread posted and publishes every frame through the triple buffer. Every other export
+	// that reads or changes the linkage stops it first, so the two never touch the linkage at the same time.
+	struct SimulationCommand {
+		enum class Type { ROTATION, SPEED } type;
+		int vertex_index;
+		float value;
+	};
+
+	struct SimulationFrame {
+		vector<float> xy; // x0, y0, x1, y1, ...
+		int generation = 0; // 0 = nothing simulated yet
+	};
+
+	static thread simulation_thread;
+	static atomic<bool> simulation_stop_requested(false);
+	static SpscQueue<SimulationCommand, 1024> simulation_commands; // main thread -> simulation thread
+	static TripleBuffer<SimulationFrame> simulation_frames; // simulation thread -> main thread
+
+	void run_simulation_thread(float dt) {
+		const auto period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(dt));
+		auto next_tick = chrono::steady_clock::now();
+		vector<float> x(num_vertices), y(num_vertices);
+		int generation = 0;
+		while (!simulation_stop_requested) {
+			SimulationCommand command;
+			while (simulation_commands.pop(command)) {
+				MotorizedVertex* m_vert = find_motor(command.vertex_index);
+				if (m_vert == nullptr) continue;
+				if (command.type == SimulationCommand::Type::ROTATION) m_vert->current_rotation = command.value;
+				else m_vert->speed = command.value;
+			}
+			advance_motors(dt);
+			simulate_frame(x.data(), y.data(), nullptr);
+
+			SimulationFrame& frame = simulation_frames.back();
+			for (int v = 0; v < num_vertices; v++) {
+				frame.xy[2 * v] = x[v];
+				frame.xy[2 * v + 1] = y[v];
+			}
+			frame.generation = ++generation;
+			simulation_frames.publish();
+
+			// fixed rate on average, but after a long stall (a breakpoint, a suspended app) do not race to catch up
+			next_tick += period;
+			auto now = chrono::steady_clock::now();
+			if (now - next_tick > 100 * period) next_tick = now;
+			this_thread::sleep_until(next_tick);
+		}
+	}
+
+	bool start_simulation_thread(float steps_per_second) {
+		stop_simulation_thread();
+		stop_design_exploration();
+		if (!(steps_per_second > 0) || num_vertices == 0) return false;
+		for (int i = 0; i < 3; i++) {
+			simulation_frames.buffer(i).xy.assign(2 * num_vertices, 0);
+			simulation_frames.buffer(i).generation = 0;
+		}
+		simulation_frames.reset();
+		simulation_commands.clear();
+		simulation_stop_requested = false;
+		simulation_thread = thread(run_simulation_thread, 1 / steps_per_second);
+		return true;
+	}
+
+	void stop_simulation_thread() {
+		simulation_stop_requested = true;
+		if (simulation_thread.joinable()) simulation_thread.join();
+	}
+
+	bool is_simulation_thread_running() {
+		return simulation_thread.joinable(); // it only ends when stopped, and stopping joins it
+	}
+
+	const float* acquire_latest_frame(int* generation) {
+		simulation_frames.acquire();
+		const SimulationFrame& frame = simulation_frames.front();
+		if (generation != nullptr) *generation = frame.generation;
+		return frame.generation > 0 ? frame.xy.data() : nullptr;
+	}
+
+	bool post_motor_rotation(int vertex_index, float rotation) {
+		if (find_motor(vertex_index) == nullptr) return false;
+		return simulation_commands.push({ SimulationCommand::Type::ROTATION, vertex_index, rotation });
+	}
+
+	bool post_motor_speed(int vertex_index, float speed) {
+		if (find_motor(vertex_index) == nullptr) return false;
+		return simulation_commands.push({ SimulationCommand::Type::SPEED, vertex_index, speed });
+	}
+
+	// --- instancing ---
+
+	// Many copies of the prepared linkage, one column each in population layout, so every step of the simulation
+	// is vectorized across instances. Only the motor angle and the world transform differ between them.
+	// Lengths, anchors and the sizes are copied at create_instances(), the dyad plan and phases are read live.
+	static int num_instances = 0;
+	static int instance_num_vertices = 0, instance_num_edges = 0, instance_num_anchors = 0;
+	static PopulationArray instance_edge_lengths; // the lengths at create_instances(), replicated
+	static PopulationArray instance_anchor_positions; // rows x0, y0, x1, y1, ... of static_verts, replicated
+	static vector<float> instance_base_rotations; // per motor, at create_instances()
+	static PopulationArray instance_rotations; // one row per motor, the same crank angle for all motors of an instance
+	static Array<float, 1, Dynamic> instance_speeds; // radians per second
+	static PopulationArray instance_transforms; // rows x, y, scale * cos(angle), scale * sin(angle)
+
+	int create_instances(int count) {
+		stop_simulation_thread();
+		num_instances = 0;
+		if (count <= 0 || num_vertices == 0 || !loop_closure_verts.empty()) return 0;
+		instance_num_vertices = num_vertices;
+		instance_num_edges = edges.size();
+		instance_num_anchors = static_verts.size();
+		instance_edge_lengths = current_edge_lengths().cast<float>().replicate(1, count).array();
+		instance_anchor_positions.resize(2 * static_verts.size(), count);
+		int s = 0;
+		for (const StaticVertex& s_vert : static_verts) {
+			instance_anchor_positions.row(2 * s).setConstant(s_vert.initial_x);
+			instance_anchor_positions.row(2 * s + 1).setConstant(s_vert.initial_y);
+			s++;
+		}
+		instance_base_rotations = current_motor_rotations();
+		instance_rotations.setZero(motorized_verts.size(), count);
+		instance_speeds.setZero(count);
+		instance_transforms.setZero(4, count);
+		instance_transforms.row(2).setOnes();
+		num_instances = count;
+		return count;
+	}
+
+	void set_instance_states(int first, int count, const float* rotations, const float* speeds, const float* transforms) {
+		first = max(first, 0);
+		count = min(count, num_instances - first);
+		for (int i = first; i < first + count; i++) {
+			if (rotations != nullptr) instance_rotations.col(i).setConstant(rotations[i - first]);
+			if (speeds != nullptr) instance_speeds(i) = speeds[i - first];
+			if (transforms != nullptr) {
+				const float* t = transforms + 4 * (i - first);
+				instance_transforms.col(i) << t[0], t[1], t[3] * cos(t[2]), t[3] * sin(t[2]);
 			}
 		}
+	}
+
+	int get_instance_output_size(int format) {
+		switch (format) {
+		case 0: return 2 * instance_num_vertices;
+		case 1: return 4 * instance_num_edges;
+		case 2: return 16 * instance_num_edges;
+		default: return 0;
+		}
+	}
+
+	// whether the linkage still has the shape the instances were created from
+	static bool instances_match_linkage() {
+		return num_vertices == instance_num_vertices && edges.size() == instance_num_edges
+			&& static_verts.size() == instance_num_anchors && motorized_verts.size() == instance_base_rotations.size()
+			&& loop_closure_verts.empty();
+	}
+
+	bool step_instances(float dt, float* output, int format) {
+		stop_simulation_thread();
+		const int instance_size = get_instance_output_size(format);
+		if (num_instances == 0 || instance_size == 0 || !instances_match_linkage()) return false;
+		// wrapped every step, float angles lose precision quickly as they grow
+		const float turn = 2 * EIGEN_PI;
+		instance_rotations.rowwise() += instance_speeds * dt;
+		instance_rotations -= turn * (instance_rotations / turn).floor();
+		if (output == nullptr) return true;
+
+		const int num_chunks = (num_instances + population_chunk_size - 1) / population_chunk_size;
+		parallel_for(num_chunks, [&](int c) {
+			const int begin = c * population_chunk_size;
+			const int count = min(population_chunk_size, num_instances - begin);
+			PopulationArray x, y;
+			simulate_population_chunk<float>(instance_edge_lengths, instance_anchor_positions, instance_base_rotations, begin, count,
+				x, y, nullptr, &instance_rotations);
+			// into world space, x' = tx + s (cos x - sin y), y' = ty + s (sin x + cos y)
+			auto tx = instance_transforms.row(0).segment(begin, count), ty = instance_transforms.row(1).segment(begin, count);
+			auto a = instance_transforms.row(2).segment(begin, count), b = instance_transforms.row(3).segment(begin, count);
+			Array<float, 1, Dynamic> local_x;
+			for (int v = 0; v < num_vertices; v++) {
+				local_x = x.row(v);
+				x.row(v) = tx + a * local_x - b * y.row(v);
+				y.row(v) = ty + b * local_x + a * y.row(v);
+			}
+			float* out = output + (size_t)begin * instance_size;
+			if (format != 0) {
+				write_edge_transforms(x, y, format - 1, out);
+				return;
+			}
+			for (int i = 0; i < count; i++) {
+				for (int v = 0; v < num_vertices; v++, out += 2) {
+					out[0] = x(v, i);
+					out[1] = y(v, i);
+				}
+			}
+		});
 		return true;
 	}
 
+	void destroy_instances() {
+		num_instances = 0;
+		instance_num_vertices = instance_num_edges = instance_num_anchors = 0;
+		instance_edge_lengths = PopulationArray();
+		instance_anchor_positions = PopulationArray();
+		instance_rotations = PopulationArray();
+		instance_transforms = PopulationArray();
+		instance_speeds = Array<float, 1, Dynamic>();
+		instance_base_rotations.clear();
+	}
+
 }
@@ -19,14 +19,116 @@ namespace Symbo {
 	extern "C" SYMBOLINKAGE_API int add_dynamic_vertex(float x, float y);
 	// add link between vertices (order is irrelevant)
 	extern "C" SYMBOLINKAGE_API void add_edge(int index_1, int index_2);
-	// must be called after all vertices/edges have been added and before simulating
+	// one vertex for load_linkage(), type is a VertexType (0 = static, 1 = motorized, 2 = dynamic),
+	// motor_vertex is only read for motorized vertices
+	struct VertexDesc {
+		float x, y;
+		int type;
+		int motor_vertex;
+	};
+	// replaces the linkage by verts[0..nv) (vertex v gets index v) and the edges (edge_pairs[2e], edge_pairs[2e + 1]),
+	// like init() followed by the add_?_vertex and add_edge calls, but in one call. Motor vertices may come later
+	// in the array than the vertices they drive. Either array may be nullptr if its count is 0. Returns false and leaves
+	// an empty linkage if a type or index is invalid, or an array with a positive count is nullptr.
+	extern "C" SYMBOLINKAGE_API bool load_linkage(const VertexDesc* verts, int nv, const int* edge_pairs, int ne);
+	// must be called after all vertices/edges have been added and before simulating.
+	// Dynamic vertices that cannot be placed from two known neighbours (triads, Stephenson linkages, ...)
+	// are solved from their loop-closure constraints. Returns false if some vertex is under-constrained.
 	extern "C" SYMBOLINKAGE_API bool prepare_simulation();
+	// writes the prepared linkage to a versioned little-endian binary file (see LinkageFile.h): vertices, edges,
+	// motor bindings and the plan prepare_simulation() compiled, with the current (possibly optimized) lengths
+	// and assembly mode. Call after prepare_simulation(). Returns false if the file cannot be written.
+	extern "C" SYMBOLINKAGE_API bool save_linkage_file(const char* path);
+	// replaces the linkage by one written with save_linkage_file(), ready to simulate without prepare_simulation().
+	// The file is memory-mapped and its arrays are copied once, straight from the mapping, into the vertices, edges
+	// and dyads (no parsing, no dyad ordering; the loop-closure vertices are collected again in one linear pass);
+	// the mapping is released before returning. Returns false (and
+	// leaves an empty linkage if the contents were inconsistent) for missing, truncated or foreign files, other
+	// versions and big-endian hosts.
+	extern "C" SYMBOLINKAGE_API bool load_linkage_file(const char* path);
 
 	// --- control ---
 	extern "C" SYMBOLINKAGE_API void set_motor_rotation(int vertex_index, float rotation);
+	// sets rotations[m] on motorized vertex vertex_indices[m] for m < n, in constant time per motor. With vertex_indices
+	// = nullptr, rotations is dense: one per motorized vertex in the order they were added. Other indices are ignored.
+	extern "C" SYMBOLINKAGE_API void set_motor_rotations(const int* vertex_indices, const float* rotations, int n);
+	// motor clock for step(): speed in radians per second. speed_profile (may be nullptr) multiplies the speed,
+	// profile_size samples spread evenly over one turn of the rotation and linearly interpolated, e.g. for
+	// quick-return drives. step() follows the profile within a frame however long it is (substeps of at most an
+	// eighth of a sample interval, up to 4096 per frame). The motor's phase offset is a linkage parameter (see set_parameters()) and stays as it is.
+	extern "C" SYMBOLINKAGE_API void set_motor_drive(int vertex_index, float speed, const float* speed_profile, int profile_size);
+	// advances every motor by dt seconds at its speed and simulates, see simulate() for the return value.
+	// The state before and after the step are kept for get_interpolated_positions(). Without a large enough
+	// output buffer it returns -1 before advancing, so the motors and the kept states stay as they were.
+	extern "C" SYMBOLINKAGE_API int step(float dt);
+	// positions alpha (0..1) of the way from the second-to-last to the last state step() reached, interleaved into
+	// xy (x0, y0, x1, y1, ...), for rendering between coarse fixed steps. Cubic in time, matching positions and
+	// joint velocities at both states. resolve = true interpolates only the motors and solves the linkage there,
+	// so link lengths stay exact at the cost of one simulation. Returns false if step() has not been called since
+	// init(); after one step, the latest state is returned. Does not change the simulation state.
+	extern "C" SYMBOLINKAGE_API bool get_interpolated_positions(float alpha, bool resolve, float* xy);
+	// with branch tracking, get_simulated_positions() lets every dyad pass through its stretched (collinear)
+	// position onto the other branch when the motion of the previous frames continues there, instead of
+	// bouncing back on the side fixed by prepare_simulation(). The assembly mode follows along. Dyads that
+	// cannot close are shown stretched out instead of as NaN. Enabling restarts the tracking history.
+	// Passing onto the other branch changes the linkage, so it stops a running design exploration.
+	extern "C" SYMBOLINKAGE_API void set_branch_tracking(bool enabled);
 
 	// --- simulation ---
 	extern "C" SYMBOLINKAGE_API void get_simulated_positions(float* x_output_array, float* y_output_array);
+	// binds a caller-owned buffer of 2 * capacity floats (e.g. a pinned array or NativeArray) that simulate() writes
+	// to, so per-frame readback needs no marshalling. It stays bound across init(); bind nullptr before freeing it.
+	extern "C" SYMBOLINKAGE_API void register_output_buffers(float* xy, int capacity);
+	// binds a caller-owned buffer that simulate() and step() fill with one transform per edge (in the order of add_edge),
+	// in the same pass as the positions. format 0: 4 floats (midpoint x, y and the vector from the first to the second
+	// vertex, whose length is the link's and whose direction gives its angle). format 1: a column-major 4x4 matrix (like
+	// Unity's Matrix4x4) that maps a unit bar along x onto the link, ready for instanced drawing. capacity counts edges;
+	// nothing is written if it is too small.
+	// Only written while an output buffer is registered, bind nullptr before freeing it.
+	extern "C" SYMBOLINKAGE_API void register_edge_output_buffer(float* transforms, int capacity, int format);
+	// simulates the current motor rotations into the registered buffer, interleaved (x0, y0, x1, y1, ...), and returns
+	// the new generation (1, 2, ...). Returns -1 without writing if no buffer is bound or it holds fewer vertices.
+	extern "C" SYMBOLINKAGE_API int simulate();
+	// generation of the last frame simulate() wrote, 0 if none yet
+	extern "C" SYMBOLINKAGE_API int get_output_generation();
+	// same, plus per vertex the margin to singularity: 1 - |cos| of the law-of-cosines angle of its dyad, minimized
+	// along the chain it depends on (1 for static and motorized vertices). 0 means a dyad is stretched or folded
+	// flat, negative means it does not assemble. valid[v] = 1 where margin >= 0. margin and valid may be nullptr.
+	extern "C" SYMBOLINKAGE_API void get_simulated_positions_with_margin(
+		float* x_output_array, float* y_output_array, float* margin, int* valid
+	);
+	// simulates num_samples rotations from `from` to `to` (inclusive, all motors turning together) as one batch.
+	// Returns true and writes the first rotation at which some vertex is invalid, false if all assemble.
+	// min_margin (may be nullptr) receives the smallest margin seen over the sweep.
+	extern "C" SYMBOLINKAGE_API bool find_first_invalid_rotation(float from, float to, int num_samples, float* rotation, float* min_margin);
+	// proves with interval arithmetic (bisecting down to `resolution` where needed) that the linkage assembles for
+	// every rotation in [from, to] (all motors turning together): returns 1. Returns 0 if it certainly does not
+	// assemble on [fail_from, fail_to] (the first such range, exact up to resolution), -1 if some range around
+	// [fail_from, fail_to] cannot be decided at that resolution (e.g. a dyad that just touches its stretched position).
+	// Vertices solved by loop closure are not checked.
+	extern "C" SYMBOLINKAGE_API int certify_assembly(float from, float to, float resolution, float* fail_from, float* fail_to);
+	// simulates num_samples rotations from `from` to `to` (inclusive, all motors together) as one batch and writes
+	// per sample s: transmission_angles[s * D + d], the angle between the two links of dynamic vertex d (in the order
+	// they were added, radians in [0, pi], NaN for vertices solved by loop closure), and mechanical_advantage[s],
+	// the speed of output_vertex over the speed of input_vertex (its inverse is input force / output force without
+	// losses), both speeds from the exact derivative by the motor rotation. Either array may be nullptr. Returns D,
+	// or -1 if mechanical_advantage is requested for a vertex index out of range.
+	extern "C" SYMBOLINKAGE_API int get_transmission_profile(float from, float to, int num_samples, int output_vertex,
+		int input_vertex, float* transmission_angles, float* mechanical_advantage);
+	// fits every vertex's path over one turn of the motors (all turning together, rotations 0 to 2 pi) with periodic
+	// piecewise cubics on uniform segments, doubling all of them (from 8, at most max_segments) until the estimated
+	// error is within tolerance: the largest deviation from the simulation at three test angles per segment, confirmed
+	// at fifteen, times 1.25. Sampled, so not a guaranteed bound. Keeps the result as a blob (see BakedCycle.h) and
+	// returns its size in bytes; if max_segments does not reach the tolerance, the blob records the error it has.
+	// Returns 0 if the linkage does not assemble all the way round or has loop-closure vertices.
+	extern "C" SYMBOLINKAGE_API int bake_cycle(float tolerance, int max_segments);
+	// copies the blob of the last bake_cycle() if it fits into capacity bytes, returns its size either way
+	extern "C" SYMBOLINKAGE_API int get_baked_cycle(void* blob, int capacity);
+	// positions at the given rotation from a baked blob (size bytes), interleaved into xy (x0, y0, x1, y1, ...),
+	// a few multiply-adds per vertex and no linkage needed. Returns false if the blob is not well-formed.
+	extern "C" SYMBOLINKAGE_API bool sample_baked_cycle(const void* blob, int size, float rotation, float* xy);
+	// per-vertex estimated error of a baked blob (may be nullptr), returns its number of segments or -1 if malformed
+	extern "C" SYMBOLINKAGE_API int get_baked_cycle_error(const void* blob, int size, float* error);
 
 	extern "C" SYMBOLINKAGE_API void get_edge_length_gradients_for_target_position( // this should probably be split into multiple calls
 		int vertex_index, float x, float y,
@@ -37,6 +139,96 @@ namespace Symbo {
 		int vertex_index, float x, float y
 	);
 
+	// least-squares fit of the edge lengths so that vertex_indices[t] reaches (target_xy[2t], target_xy[2t+1])
+	// while all motors are at motor_rotations[t] (Levenberg-Marquardt on the positions-by-edges jacobian).
+	// Returns false and keeps the lengths if a vertex index is out of range or the residual did not decrease.
+	extern "C" SYMBOLINKAGE_API bool fit_target_locations(
+		const int* vertex_indices, const float* target_xy, const float* motor_rotations, int num_targets
+	);
+
+	// runs the edge length optimization from num_starts latin-hypercube starts (+-spread around the current
+	// lengths) in parallel. Writes up to max_results distinct designs, best first, into edge_length_output
+	// (max_results x number of edges) and error_output, and returns how many were written.
+	extern "C" SYMBOLINKAGE_API int optimize_multi_start(
+		int vertex_index, float x, float y, int num_starts, float spread, int max_results,
+		float* edge_length_output, float* error_output
+	);
+	// gradient-free global search (CMA-ES) over all edge lengths, each generation is simulated as one batch.
+	// step_size is the initial sampling radius in edge length units. Returns false if nothing better was found.
+	extern "C" SYMBOLINKAGE_API bool optimize_global_for_target_location(
+		int vertex_index, float x, float y, float step_size, int max_generations
+	);
+	// overwrite all edge lengths (e.g. with one of the designs returned by optimize_multi_start)
+	extern "C" SYMBOLINKAGE_API void set_edge_lengths(const float* edge_lengths);
+
+	// --- linkage parameters ---
+	// All parameters as one vector: edge lengths, anchor (static vertex) positions x0, y0, x1, y1, ...,
+	// motor radii, motor phase offsets (anchors and motors in the order they were added).
+	extern "C" SYMBOLINKAGE_API int get_parameter_count();
+	extern "C" SYMBOLINKAGE_API void get_parameters(float* parameters);
+	extern "C" SYMBOLINKAGE_API void set_parameters(const float* parameters);
+	// chooses what the parameter optimization may change (both arrays have get_parameter_count() entries):
+	// parameter p follows variable free_index[p] (-1 = fixed) times scale[p] (nullptr = all 1).
+	// Parameters sharing a variable are tied, e.g. mirrored legs. free_index = nullptr restores the default
+	// (every active edge and motor radius). Returns the number of variables.
+	extern "C" SYMBOLINKAGE_API int select_free_parameters(const int* free_index, const float* scale);
+	// writes d(distance of vertex_index to target) / d(variable) for every variable and returns the distance
+	extern "C" SYMBOLINKAGE_API float get_parameter_gradients_for_target_position(
+		int vertex_index, float x, float y, float* gradient
+	);
+	extern "C" SYMBOLINKAGE_API bool optimize_parameters_for_target_location(int vertex_index, float x, float y);
+	// call every frame while the target of vertex_index is dragged. Instead of optimizing from scratch, the
+	// previous frame's solution is carried along the drag (tangent prediction + a few Newton corrections),
+	// so the linkage follows the cursor smoothly. The first call after end_target_drag() (or with another
+	// vertex) starts from the current linkage. Returns false if the linkage does not assemble.
+	extern "C" SYMBOLINKAGE_API bool drag_target_location(int vertex_index, float x, float y);
+	extern "C" SYMBOLINKAGE_API void end_target_drag();
+
+	// --- assembly modes ---
+	// Every dynamic vertex can close its triangle on either side of its two neighbours.
+	// One flag per dynamic vertex (in the order they were added): 0 = the side it was placed on, 1 = mirrored.
+	// Returns the number of dynamic vertices.
+	extern "C" SYMBOLINKAGE_API int get_assembly_mode(int* mirrored);
+	extern "C" SYMBOLINKAGE_API void set_assembly_mode(const int* mirrored);
+	// searches all assembly modes (branch and bound, in parallel) for the one that brings vertex_index closest
+	// to (x, y) at the current motor rotations and switches to it. distance (may be nullptr) receives how close
+	// it gets. Returns false if no mode assembles.
+	extern "C" SYMBOLINKAGE_API bool optimize_assembly_mode_for_target_location(int vertex_index, float x, float y, float* distance);
+
+	// --- multi-objective design exploration ---
+	// A design is all edge lengths followed by the anchor (static vertex) positions x0, y0, x1, y1, ...
+	extern "C" SYMBOLINKAGE_API int get_design_size();
+	// overwrite the static vertex positions (2 floats each, in the order they were added)
+	extern "C" SYMBOLINKAGE_API void set_anchor_positions(const float* xy);
+	// starts NSGA-II on a background thread. Every design is simulated over num_samples motor angles and scored
+	// by stride length, foot path flatness, peak joint velocity and minimum transmission angle of foot_vertex's
+	// linkage. Edges vary by +-edge_spread (relative), anchors by +-anchor_spread (absolute).
+	// Every export that changes the linkage (edits, lengths, anchors, assembly mode, the optimizers) stops it first,
+	// so do not expect it to keep running across such calls; motor rotations and speeds may change freely.
+	extern "C" SYMBOLINKAGE_API bool start_design_exploration(
+		int foot_vertex, int num_samples, int population_size, float edge_spread, float anchor_spread
+	);
+	// CMA-ES on the weighted sum of the 4 cycle objectives above (positive weights = longer stride, flatter path,
+	// lower peak velocity, larger transmission angle), starting from the current design with step_size as initial
+	// sampling radius. With use_surrogate, candidates are ranked by an RBF model first and only the promising half
+	// of each generation is simulated. Reports the simulated and the skipped designs (either may be nullptr), applies
+	// the best design. Returns false if weights is nullptr, or nothing better than the current design was found.
+	extern "C" SYMBOLINKAGE_API bool optimize_cycle_objectives(
+		int foot_vertex, int num_samples, const float* weights, float step_size, int max_generations,
+		bool use_surrogate, int* true_evaluations, int* saved_evaluations
+	);
+	// constraint for the exploration and optimize_cycle_objectives: every sample at which some transmission angle
+	// leaves [min_angle, pi - min_angle] counts as violated, like a sample that does not assemble. 0 = no limit.
+	// Changing it stops a running exploration; init() resets it.
+	extern "C" SYMBOLINKAGE_API void set_transmission_angle_limit(float min_angle);
+	// must also be called before the DLL is unloaded
+	extern "C" SYMBOLINKAGE_API void stop_design_exploration();
+	// copies the latest Pareto front (can be called while exploring): up to max_designs designs
+	// (max_designs x get_design_size()) and their objectives (max_designs x 4: stride, flatness,
+	// peak velocity, min transmission angle in radians). Returns the number of designs written. Any of the
+	// outputs, including generation, may be nullptr.
+	extern "C" SYMBOLINKAGE_API int get_pareto_front(float* designs, float* objectives, int max_designs, int* generation);
+
 
 	// DEPRECATED
 	extern "C" SYMBOLINKAGE_API void symbolic_kinematic(
@@ -45,4 +237,47 @@ namespace Symbo {
 		float* output_array
 	);
 
+	// --- background simulation ---
+
+	// runs step() at a fixed rate on an engine-owned thread (e.g. 1000 for contact detection), independent of
+	// the caller's frame rate. Any other export that reads or changes the linkage or the motors (including
+	// step(), simulate() and the optimizers) stops the thread first, as does starting a design exploration; use
+	// the post_* commands below to steer it meanwhile. Returns false for a non-positive rate.
+	extern "C" SYMBOLINKAGE_API bool start_simulation_thread(float steps_per_second);
+	extern "C" SYMBOLINKAGE_API void stop_simulation_thread();
+	// whether the simulation thread is running: false once stop_simulation_thread() or any of the exports above
+	// stopped it, so a caller can tell after such a call that it has to start the thread again
+	extern "C" SYMBOLINKAGE_API bool is_simulation_thread_running();
+	// the newest complete frame of the simulation thread, interleaved (x0, y0, x1, y1, ...). Never waits. The data
+	// stays valid and unchanged until the next call, nullptr if no frame is done yet. generation (may be nullptr)
+	// counts the frames simulated since the start, equal to the previous call if nothing new arrived.
+	extern "C" SYMBOLINKAGE_API const float* acquire_latest_frame(int* generation);
+	// queue a control change for the simulation thread, applied before its next step. Never waits, returns false
+	// if vertex_index is not motorized or the queue is full (the thread is not keeping up).
+	extern "C" SYMBOLINKAGE_API bool post_motor_rotation(int vertex_index, float rotation);
+	extern "C" SYMBOLINKAGE_API bool post_motor_speed(int vertex_index, float speed);
+
+	// --- instancing ---
+
+	// copies of the current linkage (prepared, without loop closures) for crowds of identical mechanisms, each with
+	// its own crank angle, speed and world transform, all simulated together by step_instances(). The edge lengths,
+	// anchor positions, motor angles and output size are copied; which vertex hangs on which (the prepared dyads),
+	// motor phases and radii of motors without an edge are read from the linkage on every step, so create the
+	// instances again after changing the linkage. Returns count, or 0 if the linkage cannot be instanced.
+	extern "C" SYMBOLINKAGE_API int create_instances(int count);
+	// instances [first, first + count): rotations (count) is the crank angle added to every motor, speeds (count)
+	// in radians per second, transforms (4 x count) is x, y, angle, uniform scale. Any of them may be nullptr to
+	// keep the current values. New instances start at angle 0, speed 0, identity transform.
+	extern "C" SYMBOLINKAGE_API void set_instance_states(int first, int count, const float* rotations, const float* speeds, const float* transforms);
+	// floats per instance in the output of step_instances() in the given format, 0 for an unknown format. Fixed at
+	// create_instances(), so a buffer sized with it stays valid when edges or vertices are added later.
+	extern "C" SYMBOLINKAGE_API int get_instance_output_size(int format);
+	// advances every instance by dt and writes them one after the other, in world space, into output
+	// (get_instance_output_size(format) x the number of instances floats, may be nullptr to only advance).
+	// format 0: joints, x0, y0, x1, y1, ...; 1 and 2: per edge, as register_edge_output_buffer() formats 0 and 1.
+	// Instances that do not assemble at their angle come out as NaN. Returns false without writing if there are no
+	// instances, or vertices, edges, anchors or motors were added or removed since create_instances().
+	extern "C" SYMBOLINKAGE_API bool step_instances(float dt, float* output, int format);
+	extern "C" SYMBOLINKAGE_API void destroy_instances();
+
 }
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <functional>
+using namespace std;
+
+namespace Symbo {
+
+	// Threads that are started once and then take part in every run(), so that a parallel loop costs a wake-up
+	// instead of creating and joining threads. The calling thread works on its own loop as well and never waits
+	// for a worker to become free, so several threads may call run() at the same time, and a loop body may run
+	// a loop of its own, without deadlocking.
+	class WorkerPool {
+	public:
+		explicit WorkerPool(int num_workers) {
+			for (int t = 0; t < num_workers; t++) {
+				workers.emplace_back([this]() { work(); });
+			}
+		}
+
+		~WorkerPool() {
+			{
+				lock_guard<mutex> lock(jobs_mutex);
+				stopping = true;
+			}
+			job_added.notify_all();
+			for (thread& worker : workers) worker.join();
+		}
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		int num_workers() const { return workers.size(); }
+
+		// runs body(i) for every i in [0, count), returns when all are done
+		void run(int count, const function<void(int)>& body) {
+			Job job{ &body, count };
+			{
+				lock_guard<mutex> lock(jobs_mutex);
+				jobs.push_back(&job);
+			}
+			job_added.notify_all();
+			for (int i = job.next++; i < count; i = job.next++) body(i);
+
+			unique_lock<mutex> lock(jobs_mutex);
+			job_finished.wait(lock, [&]() { return job.active == 0; }); // workers still finishing their index
+			jobs.erase(find(jobs.begin(), jobs.end(), &job));
+		}
+
+	private:
+		struct Job {
+			const function<void(int)>* body;
+			int count;
+			atomic<int> next{ 0 };
+			int active = 0; // workers inside the job, guarded by jobs_mutex
+		};
+
+		// a job with indices left, nullptr if there is none
+		Job* open_job() const {
+			for (Job* job : jobs) {
+				if (job->next < job->count) return job;
+			}
+			return nullptr;
+		}
+
+		void work() {
+			unique_lock<mutex> lock(jobs_mutex);
+			while (true) {
+				Job* job;
+				job_added.wait(lock, [&]() { return stopping || (job = open_job()) != nullptr; });
+				if (stopping) return;
+				job->active++;
+				lock.unlock();
+				for (int i = job->next++; i < job->count; i = job->next++) (*job->body)(i);
+				lock.lock();
+				if (--job->active == 0) job_finished.notify_all();
+			}
+		}
+
+		vector<thread> workers;
+		mutex jobs_mutex;
+		condition_variable job_added, job_finished;
+		vector<Job*> jobs; // of the threads currently in run()
+		bool stopping = false;
+	};
+
+}
@@ -0,0 +1,79 @@
+// CppNumericalSolver
+#ifndef LEASTSQUARESPROBLEM_H
+#define LEASTSQUARESPROBLEM_H
+
+#include <Eigen/Core>
+
+#include "problem.h"
+
+namespace cppoptlib {
+
+/**
+ * @brief problem of the form f(x) = 1/2 * ||r(x)||^2
+ * @details keeps the residual structure around, so that Gauss-Newton type solvers
+ *          can work with the jacobian of r instead of only the gradient of f.
+ */
+template<typename Scalar_, int Dim_ = Eigen::Dynamic>
+class LeastSquaresProblem : public Problem<Scalar_, Dim_> {
+ public:
+  using Superclass = Problem<Scalar_, Dim_>;
+  using typename Superclass::Scalar;
+  using typename Superclass::TVector;
+  using typename Superclass::TIndex;
+  using TResiduals = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+  using TJacobian  = Eigen::Matrix<Scalar, Eigen::Dynamic, Dim_>;
+
+  /**
+   * @brief returns the residual vector r(x) as reference parameter
+   */
+  virtual void residuals(const TVector &x, TResiduals &r) = 0;
+
+  /**
+   * @brief returns the jacobian dr/dx (residuals by parameters) as reference parameter
+   * @details should be overwritten by symbolic jacobian
+   */
+  virtual void jacobian(const TVector &x, TJacobian &jac) {
+    finiteJacobian(x, jac);
+  }
+
+  /**
+   * @brief objective value 1/2 * ||r(x)||^2
+   */
+  Scalar value(const TVector &x) {
+    TResiduals r;
+    residuals(x, r);
+    return static_cast<Scalar>(0.5) * r.squaredNorm();
+  }
+
+  /**
+   * @brief gradient J^T * r of the objective value
+   */
+  void gradient(const TVector &x, TVector &grad) {
+    TResiduals r;
+    TJacobian jac;
+    residuals(x, r);
+    jacobian(x, jac);
+    grad = jac.transpose() * r;
+  }
+
+  void finiteJacobian(const TVector &x, TJacobian &jac) {
+    const Scalar eps = 2.2204e-6;
+    TVector &xx = const_cast<TVector &>(x);
+    TResiduals r_plus, r_minus;
+    residuals(xx, r_plus);
+    jac.resize(r_plus.rows(), x.rows());
+    for (TIndex d = 0; d < x.rows(); d++) {
+      const Scalar tmp = xx[d];
+      xx[d] = tmp + eps;
+      residuals(xx, r_plus);
+      xx[d] = tmp - eps;
+      residuals(xx, r_minus);
+      xx[d] = tmp;
+      jac.col(d) = (r_plus - r_minus) / (2 * eps);
+    }
+  }
+};
+
+} // end namespace cppoptlib
+
+#endif /* LEASTSQUARESPROBLEM_H */
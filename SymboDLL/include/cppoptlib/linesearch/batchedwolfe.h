@@ -0,0 +1,84 @@
+// CppNumericalSolver
+#ifndef BATCHEDWOLFE_H_
+#define BATCHEDWOLFE_H_
+
+#include "../meta.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace cppoptlib {
+
+/**
+ * @brief line search that probes a whole bracket of step lengths in one Problem::batchValue call
+ * @details the bracket alpha_init * 4, 2, 1, 1/2, ... (kSteps candidates) is evaluated at once, so problems
+ *          that vectorize or parallelize batchValue pay for roughly one evaluation instead of several.
+ *          Of the candidates that satisfy sufficient decrease, the lowest ones are checked for the strong
+ *          curvature condition (one gradient each). If none passes, the lowest sufficient one is taken.
+ *          If no candidate decreases enough, the next smaller bracket is tried.
+ */
+template<typename ProblemType, int Ord>
+class BatchedWolfe {
+ public:
+  using Scalar = typename ProblemType::Scalar;
+  using TVector = typename ProblemType::TVector;
+  using MatrixType = typename ProblemType::MatrixType;
+  using TValues = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+  static const int kSteps = 8;
+  static const int kBrackets = 3;
+  static const int kCurvatureChecks = 2;
+
+  static Scalar linesearch(const TVector &x, const TVector &searchDir, ProblemType &objFunc, const Scalar alpha_init = 1.0) {
+    const Scalar c1 = 1e-4;
+    const Scalar c2 = 0.9;
+
+    TVector grad(x.rows());
+    objFunc.gradient(x, grad);
+    const Scalar dginit = grad.dot(searchDir);
+    if (!(dginit < 0)) {
+      return 0; // no descent direction
+    }
+
+    Scalar alpha_max = 4 * alpha_init;
+    for (int bracket = 0; bracket < kBrackets; ++bracket) {
+      // column 0 is the start, so that it is compared in the same precision as the candidates
+      MatrixType candidates(x.rows(), kSteps + 1);
+      std::vector<Scalar> steps(kSteps + 1, 0);
+      candidates.col(0) = x;
+      for (int k = 1; k <= kSteps; ++k) {
+        steps[k] = alpha_max * std::pow(static_cast<Scalar>(0.5), k - 1);
+        candidates.col(k) = x + steps[k] * searchDir;
+      }
+      TValues values;
+      objFunc.batchValue(candidates, values);
+      const Scalar finit = values[0];
+
+      std::vector<int> sufficient;
+      for (int k = 1; k <= kSteps; ++k) {
+        if (std::isfinite(values[k]) && values[k] <= finit + c1 * steps[k] * dginit) {
+          sufficient.push_back(k);
+        }
+      }
+      if (sufficient.empty()) {
+        alpha_max = steps[kSteps] / 2;
+        continue;
+      }
+      std::sort(sufficient.begin(), sufficient.end(), [&](int a, int b) { return values[a] < values[b]; });
+
+      for (int c = 0; c < std::min<int>(kCurvatureChecks, sufficient.size()); ++c) {
+        const Scalar step = steps[sufficient[c]];
+        objFunc.gradient(candidates.col(sufficient[c]), grad);
+        if (std::abs(grad.dot(searchDir)) <= c2 * std::abs(dginit)) {
+          return step;
+        }
+      }
+      return steps[sufficient[0]];
+    }
+    return 0;
+  }
+};
+
+}
+
+#endif /* BATCHEDWOLFE_H_ */
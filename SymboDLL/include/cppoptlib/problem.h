@@ -5,6 +5,8 @@
 
 #include <array>
 #include <vector>
+#include <cmath>
+#include <limits>
 #include <Eigen/Core>
 
 #include "meta.h"
@@ -56,6 +58,20 @@ class Problem {
   Scalar operator()(const  TVector &x) {
     return value(x);
   }
+  /**
+   * @brief evaluates the objective for every column of x
+   * @details population based solvers call this once per generation.
+   *          Override it to evaluate all candidates at once (vectorized or threaded).
+   *
+   * @param x one candidate per column
+   * @param values objective value per candidate
+   */
+  virtual void batchValue(const MatrixType &x, Eigen::Matrix<Scalar, Eigen::Dynamic, 1> &values) {
+    values.resize(x.cols());
+    for (TIndex c = 0; c < x.cols(); ++c) {
+      values[c] = value(x.col(c));
+    }
+  }
   /**
    * @brief returns gradient in x as reference parameter
    * @details should be overwritten by symbolic gradient
@@ -74,6 +90,24 @@ class Problem {
     finiteHessian(x, hessian);
   }
 
+  /**
+   * @brief returns hessian(x) * v as reference parameter
+   * @details used by solvers that never need the full hessian (trust region Newton-CG).
+   *          The default differentiates the gradient along v, override it with an exact product if possible.
+   */
+  virtual void hessianVectorProduct(const TVector &x, const TVector &v, TVector &hv) {
+    const Scalar vNorm = v.norm();
+    if (vNorm == 0) {
+      hv = TVector::Zero(x.rows());
+      return;
+    }
+    const Scalar eps = std::sqrt(std::numeric_limits<Scalar>::epsilon()) * std::max(static_cast<Scalar>(1), x.norm()) / vNorm;
+    TVector gradPlus(x.rows()), gradMinus(x.rows());
+    gradient(x + eps * v, gradPlus);
+    gradient(x - eps * v, gradMinus);
+    hv = (gradPlus - gradMinus) / (2 * eps);
+  }
+
   virtual bool checkGradient(const TVector &x, int accuracy = 3) {
     // TODO: check if derived class exists:
     // int(typeid(&Rosenbrock<double>::gradient) == typeid(&Problem<double>::gradient)) == 1 --> overwritten
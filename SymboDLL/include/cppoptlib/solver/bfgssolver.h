@@ -9,7 +9,8 @@
 
 namespace cppoptlib {
 
-template<typename ProblemType>
+// LineSearch can be swapped, e.g. for BatchedWolfe when the problem evaluates batches efficiently
+template<typename ProblemType, template<typename, int> class LineSearch = MoreThuente>
 class BfgsSolver : public ISolver<ProblemType, 1> {
   public:
     using Superclass = ISolver<ProblemType, 1>;
@@ -36,7 +37,7 @@ class BfgsSolver : public ISolver<ProblemType, 1> {
                 searchDir = -1 * grad;
             }
 
-            const Scalar rate = MoreThuente<ProblemType, 1>::linesearch(x0, searchDir, objFunc) ;
+            const Scalar rate = LineSearch<ProblemType, 1>::linesearch(x0, searchDir, objFunc) ;
             x0 = x0 + rate * searchDir;
 
             TVector grad_old = grad;
@@ -68,6 +68,11 @@ public:
         Super::m_stop.fDelta = 1e-9;
     }
 
+    /**
+     * @brief initial sigma of the sampling distribution
+     */
+    void setStepSize(const Scalar stepSize) { m_stepSize = stepSize; }
+
     /**
     * @brief minimize
     * @details [long description]
@@ -109,7 +114,9 @@ public:
         TVector zmean = TVector::Zero(n);
         TMatrix arz(n, la);
         TMatrix arx(n, la);
+        TMatrix arx_clipped(n, la);
         TVarVector costs(la);
+        TVarVector penalties(la);
         Scalar prevCost = objFunc.value(x0);
         // Constraint handling
         TVector gamma = TVector::Ones();
@@ -147,8 +154,12 @@ public:
                   }
                   penalty += (dist*dist) / eta;
               }
-              costs[k] = objFunc(xk) + penalty/n;
+              arx_clipped.col(k) = xk;
+              penalties[k] = penalty/n;
             }
+            // the whole generation is evaluated in one call, so problems can batch it
+            objFunc.batchValue(arx_clipped, costs);
+            costs += penalties;
 
             if (Super::m_debug >= DebugLevel::High) {
                 std::cout << "arz" << std::endl << arz << std::endl;
@@ -66,6 +66,11 @@ public:
         Super::m_stop.fDelta = 1e-9;
     }
 
+    /**
+     * @brief initial sigma of the sampling distribution
+     */
+    void setStepSize(const Scalar stepSize) { m_stepSize = stepSize; }
+
     void minimize(TProblem &objFunc, TVector &x0) {
         TVector var0 = TVector::Ones(x0.rows());
         this->minimize(objFunc, x0, var0);
@@ -129,8 +134,9 @@ public:
             for (int k = 0; k < la; ++k) {
               arz.col(k) = normDist(n);
               arx.col(k) = xmean + sigma * B*D*arz.col(k);
-              costs[k] = objFunc(arx.col(k));
             }
+            // the whole generation is evaluated in one call, so problems can batch it
+            objFunc.batchValue(arx, costs);
             if (Super::m_debug >= DebugLevel::High) {
                 std::cout << "arz" << std::endl << arz << std::endl;
                 std::cout << "arx" << std::endl << arx << std::endl;
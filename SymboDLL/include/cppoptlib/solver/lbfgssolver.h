@@ -12,7 +12,8 @@
 
 namespace cppoptlib {
 
-template<typename ProblemType>
+// LineSearch can be swapped, e.g. for BatchedWolfe when the problem evaluates batches efficiently
+template<typename ProblemType, template<typename, int> class LineSearch = MoreThuente>
 class LbfgsSolver : public ISolver<ProblemType, 1> {
   public:
     using Superclass = ISolver<ProblemType, 1>;
@@ -76,7 +77,7 @@ class LbfgsSolver : public ISolver<ProblemType, 1> {
             }
 
             // find steplength
-            const Scalar rate = MoreThuente<ProblemType, 1>::linesearch(x0, -q,  objFunc, alpha_init) ;
+            const Scalar rate = LineSearch<ProblemType, 1>::linesearch(x0, -q,  objFunc, alpha_init) ;
             // update guess
             x0 = x0 - rate * q;
 
@@ -0,0 +1,110 @@
+// CppNumericalSolver
+// based on:
+// Methods for Non-Linear Least Squares Problems, 2nd ed.
+// K. Madsen, H. B. Nielsen and O. Tingleff
+#include <iostream>
+#include <cmath>
+#include <Eigen/Cholesky>
+#include "isolver.h"
+#include "../leastsquaresproblem.h"
+
+#ifndef LEVENBERGMARQUARDTSOLVER_H_
+#define LEVENBERGMARQUARDTSOLVER_H_
+
+namespace cppoptlib {
+
+/**
+ * @brief Levenberg-Marquardt for problems derived from LeastSquaresProblem
+ * @details solves (J^T J + lambda * diag(J^T J)) dx = -J^T r in every iteration.
+ *          lambda shrinks after successful steps, so close to the solution this
+ *          turns into plain Gauss-Newton.
+ */
+template<typename ProblemType>
+class LevenbergMarquardtSolver : public ISolver<ProblemType, 1> {
+  public:
+    using Superclass = ISolver<ProblemType, 1>;
+    using typename Superclass::Scalar;
+    using typename Superclass::TVector;
+    using typename Superclass::THessian;
+    using TResiduals = typename ProblemType::TResiduals;
+    using TJacobian = typename ProblemType::TJacobian;
+
+  protected:
+    Scalar m_lambda0 = 1e-3;
+
+  public:
+    LevenbergMarquardtSolver() {
+        // least squares problems usually converge within a few dozen iterations
+        this->m_stop.iterations = 200;
+        this->m_stop.xDelta = 1e-10;
+        this->m_stop.fDelta = 0;
+        this->m_stop.gradNorm = 1e-8;
+    }
+
+    /**
+     * @brief initial damping, relative to the diagonal of J^T J
+     */
+    void setInitialDamping(const Scalar lambda0) { m_lambda0 = lambda0; }
+
+    void minimize(ProblemType &objFunc, TVector &x0) {
+        TResiduals r, r_new;
+        TJacobian jac;
+        objFunc.residuals(x0, r);
+        objFunc.jacobian(x0, jac);
+        Scalar cost = static_cast<Scalar>(0.5) * r.squaredNorm();
+
+        Scalar lambda = m_lambda0;
+        Scalar nu = 2;
+        this->m_current.reset();
+        do {
+            const THessian A = jac.transpose() * jac;
+            const TVector g = jac.transpose() * r;
+            this->m_current.gradNorm = g.template lpNorm<Eigen::Infinity>();
+            if (this->m_current.gradNorm < this->m_stop.gradNorm) {
+                this->m_status = Status::GradNormTolerance;
+                break;
+            }
+
+            // Marquardt scaling, with a floor so that unused parameters do not make the system singular
+            TVector D = A.diagonal().cwiseMax(static_cast<Scalar>(1e-9));
+            THessian damped = A;
+            damped.diagonal() += lambda * D;
+            const TVector delta_x = damped.ldlt().solve(-g);
+
+            const TVector x_new = x0 + delta_x;
+            objFunc.residuals(x_new, r_new);
+            const Scalar cost_new = static_cast<Scalar>(0.5) * r_new.squaredNorm();
+
+            // gain ratio between actual and predicted decrease
+            const Scalar predicted = static_cast<Scalar>(0.5) * delta_x.dot(lambda * D.cwiseProduct(delta_x) - g);
+            const Scalar rho = (cost - cost_new) / predicted;
+
+            if (std::isfinite(cost_new) && predicted > 0 && rho > 0) {
+                this->m_current.xDelta = delta_x.template lpNorm<Eigen::Infinity>();
+                this->m_current.fDelta = cost - cost_new;
+                x0 = x_new;
+                r = r_new;
+                cost = cost_new;
+                objFunc.jacobian(x0, jac);
+                lambda *= std::max(static_cast<Scalar>(1. / 3.), 1 - std::pow(2 * rho - 1, 3));
+                nu = 2;
+            } else {
+                // rejected (also catches steps into infeasible configurations that produce NaN)
+                lambda *= nu;
+                nu *= 2;
+                this->m_current.xDelta = delta_x.template lpNorm<Eigen::Infinity>();
+                if (!std::isfinite(lambda) || lambda > 1e16) {
+                    this->m_status = Status::Condition;
+                    break;
+                }
+            }
+            ++this->m_current.iterations;
+            this->m_status = checkConvergence(this->m_stop, this->m_current);
+        } while (objFunc.callback(this->m_current, x0) && (this->m_status == Status::Continue));
+    }
+};
+
+}
+/* namespace cppoptlib */
+
+#endif /* LEVENBERGMARQUARDTSOLVER_H_ */
@@ -0,0 +1,148 @@
+// CppNumericalSolver
+// based on:
+// Numerical Optimization, 2nd ed., Algorithms 4.1 and 7.2 (CG-Steihaug)
+// J. Nocedal and S. J. Wright
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include "isolver.h"
+
+#ifndef TRUSTREGIONNEWTONCGSOLVER_H_
+#define TRUSTREGIONNEWTONCGSOLVER_H_
+
+namespace cppoptlib {
+
+/**
+ * @brief trust region Newton method, the subproblem is solved by truncated conjugate gradients
+ * @details only needs hessian-vector products (Problem::hessianVectorProduct), the hessian is never formed.
+ *          CG stops at the trust region boundary and on negative curvature, steps that do not decrease
+ *          the objective (including steps to NaN) shrink the region instead of being searched along.
+ */
+template<typename ProblemType>
+class TrustRegionNewtonCGSolver : public ISolver<ProblemType, 2> {
+  public:
+    using Superclass = ISolver<ProblemType, 2>;
+    using typename Superclass::Scalar;
+    using typename Superclass::TVector;
+
+  protected:
+    Scalar m_initialRadius = 1;
+    Scalar m_maxRadius = 1e3;
+    Scalar m_eta = 0.1; // minimal ratio of actual to predicted decrease for accepting a step
+    Scalar m_infeasibleValue = std::numeric_limits<Scalar>::infinity();
+
+  public:
+    TrustRegionNewtonCGSolver() {
+        this->m_stop.iterations = 500;
+        this->m_stop.xDelta = 1e-10;
+        this->m_stop.fDelta = 0;
+        this->m_stop.gradNorm = 1e-8;
+    }
+
+    void setInitialRadius(const Scalar radius) { m_initialRadius = radius; }
+    void setMaxRadius(const Scalar radius) { m_maxRadius = radius; }
+    /**
+     * @brief objective values at or above this (as well as NaN) mark infeasible points, e.g. a penalty
+     */
+    void setInfeasibleValue(const Scalar value) { m_infeasibleValue = value; }
+
+    void minimize(ProblemType &objFunc, TVector &x0) {
+        const int DIM = x0.rows();
+        TVector grad(DIM), p(DIM), hp(DIM);
+        Scalar f = objFunc.value(x0);
+        objFunc.gradient(x0, grad);
+        Scalar radius = m_initialRadius;
+        bool wasRejected = false;
+        this->m_current.reset();
+        do {
+            this->m_current.gradNorm = grad.template lpNorm<Eigen::Infinity>();
+            if (this->m_current.gradNorm < this->m_stop.gradNorm) {
+                this->m_status = Status::GradNormTolerance;
+                break;
+            }
+
+            steihaug(objFunc, x0, grad, radius, p);
+            objFunc.hessianVectorProduct(x0, p, hp);
+            const Scalar predicted = -(grad.dot(p) + static_cast<Scalar>(0.5) * p.dot(hp));
+            const TVector x_new = x0 + p;
+            const Scalar f_new = objFunc.value(x_new);
+            const Scalar rho = std::isfinite(f_new) && predicted > 0
+                ? (f - f_new) / predicted : -std::numeric_limits<Scalar>::infinity();
+
+            const Scalar stepNorm = p.norm();
+            if (!std::isfinite(f_new) || f_new >= m_infeasibleValue) {
+                // left the feasible region: bisect towards its edge instead of collapsing the region
+                radius = static_cast<Scalar>(0.5) * stepNorm;
+            } else if (rho < 0.25) {
+                radius = static_cast<Scalar>(0.25) * stepNorm;
+            } else if (rho > 0.75 && stepNorm > static_cast<Scalar>(0.99) * radius && !wasRejected) {
+                // growing right after a rejection would just run into the same wall again
+                radius = std::min(2 * radius, m_maxRadius);
+            }
+            wasRejected = !(rho > m_eta);
+
+            if (rho > m_eta) {
+                this->m_current.xDelta = stepNorm;
+                this->m_current.fDelta = f - f_new;
+                x0 = x_new;
+                f = f_new;
+                objFunc.gradient(x0, grad);
+            } else {
+                // rejected, the region is the only thing left to shrink
+                this->m_current.xDelta = radius;
+            }
+            ++this->m_current.iterations;
+            this->m_status = checkConvergence(this->m_stop, this->m_current);
+        } while (objFunc.callback(this->m_current, x0) && (this->m_status == Status::Continue));
+    }
+
+  protected:
+    /**
+     * @brief approximately minimizes g^T p + 1/2 p^T H p subject to |p| <= radius
+     */
+    void steihaug(ProblemType &objFunc, const TVector &x, const TVector &grad, const Scalar radius, TVector &p) {
+        const int DIM = x.rows();
+        const Scalar gradNorm = grad.norm();
+        const Scalar tolerance = std::min(static_cast<Scalar>(0.5), std::sqrt(gradNorm)) * gradNorm;
+        p = TVector::Zero(DIM);
+        TVector r = grad;
+        TVector d = -r;
+        TVector hd(DIM);
+        for (int j = 0; j < DIM; ++j) {
+            objFunc.hessianVectorProduct(x, d, hd);
+            const Scalar curvature = d.dot(hd);
+            if (!(curvature > 0)) { // negative curvature (or NaN), go all the way to the boundary
+                p += toBoundary(p, d, radius) * d;
+                return;
+            }
+            const Scalar alpha = r.squaredNorm() / curvature;
+            const TVector p_next = p + alpha * d;
+            if (p_next.norm() >= radius) {
+                p += toBoundary(p, d, radius) * d;
+                return;
+            }
+            p = p_next;
+            const TVector r_next = r + alpha * hd;
+            if (r_next.norm() < tolerance) return;
+            const Scalar beta = r_next.squaredNorm() / r.squaredNorm();
+            r = r_next;
+            d = -r + beta * d;
+        }
+    }
+
+    /**
+     * @brief tau >= 0 with |p + tau * d| = radius
+     */
+    static Scalar toBoundary(const TVector &p, const TVector &d, const Scalar radius) {
+        const Scalar a = d.squaredNorm();
+        if (a == 0) return 0;
+        const Scalar b = 2 * p.dot(d);
+        const Scalar c = p.squaredNorm() - radius * radius;
+        return (-b + std::sqrt(std::max(static_cast<Scalar>(0), b * b - 4 * a * c))) / (2 * a);
+    }
+};
+
+}
+/* namespace cppoptlib */
+
+#endif /* TRUSTREGIONNEWTONCGSOLVER_H_ */
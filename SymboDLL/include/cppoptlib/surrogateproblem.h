@@ -0,0 +1,184 @@
+// CppNumericalSolver
+#ifndef SURROGATEPROBLEM_H
+#define SURROGATEPROBLEM_H
+
+#include <vector>
+#include <deque>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <Eigen/Core>
+#include <Eigen/QR>
+
+#include "problem.h"
+
+namespace cppoptlib {
+
+/**
+ * @brief wraps an expensive problem in a radial basis function surrogate
+ * @details every true evaluation is remembered. Once enough samples are known, batchValue ranks
+ *          the whole population with a cubic RBF interpolant (with linear tail) and only evaluates
+ *          the most promising fraction with the real problem. The others are ranked behind all
+ *          truly evaluated candidates, in the order the surrogate predicts.
+ *          Meant for population based solvers such as CMA-ES, value() is always a true evaluation.
+ */
+template<typename ProblemType>
+class SurrogateProblem : public Problem<typename ProblemType::Scalar, ProblemType::Dim> {
+ public:
+  using Superclass = Problem<typename ProblemType::Scalar, ProblemType::Dim>;
+  using typename Superclass::Scalar;
+  using typename Superclass::TVector;
+  using typename Superclass::TIndex;
+  using typename Superclass::MatrixType;
+  using TValues = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+ protected:
+  ProblemType &m_problem;
+  std::deque<TVector> m_samples;
+  std::deque<Scalar> m_sampleValues;
+  Scalar m_evaluateFraction = 0.5;
+  Scalar m_ignoreAbove = std::numeric_limits<Scalar>::infinity();
+  size_t m_maxSamples = 200;
+  size_t m_trueEvaluations = 0;
+  size_t m_savedEvaluations = 0;
+
+  // model: f(x) = sum_i w_i |x - x_i|^3 + c_0 + c^T x
+  MatrixType m_centers;
+  TValues m_weights;
+  TValues m_tail;
+  bool m_modelValid = false;
+  bool m_modelStale = false; // samples were added since the last fit
+
+ public:
+  explicit SurrogateProblem(ProblemType &problem) : m_problem(problem) {}
+
+  /**
+   * @brief share of every population that is truly evaluated once the surrogate is active
+   * @details keep it at least at the share of parents a generation selects (1/2 for CMA-ES)
+   */
+  void setEvaluateFraction(const Scalar fraction) { m_evaluateFraction = fraction; }
+  /**
+   * @brief only the most recent samples are interpolated, older ones are dropped
+   */
+  void setMaxSamples(const size_t maxSamples) { m_maxSamples = maxSamples; }
+  /**
+   * @brief samples with larger values (e.g. penalties for infeasible candidates) are not interpolated
+   */
+  void setIgnoreAbove(const Scalar threshold) { m_ignoreAbove = threshold; }
+
+  size_t trueEvaluations() const { return m_trueEvaluations; }
+  size_t savedEvaluations() const { return m_savedEvaluations; }
+
+  Scalar value(const TVector &x) {
+    const Scalar fx = m_problem.value(x);
+    ++m_trueEvaluations;
+    addSample(x, fx);
+    return fx;
+  }
+
+  void gradient(const TVector &x, TVector &grad) {
+    m_problem.gradient(x, grad);
+  }
+
+  bool callback(const Criteria<Scalar> &state, const TVector &x) {
+    return m_problem.callback(state, x);
+  }
+
+  void batchValue(const MatrixType &x, TValues &values) {
+    const TIndex n = x.cols();
+    values.resize(n);
+    // the O(n^3) fit happens once per generation, with everything evaluated since the last one
+    if (m_modelStale) fit();
+    if (!m_modelValid) {
+      m_problem.batchValue(x, values);
+      m_trueEvaluations += n;
+      for (TIndex c = 0; c < n; ++c) addSample(x.col(c), values[c]);
+      return;
+    }
+
+    // rank by prediction, evaluate the best share for real
+    TValues predicted(n);
+    for (TIndex c = 0; c < n; ++c) predicted[c] = predict(x.col(c));
+    std::vector<TIndex> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](TIndex a, TIndex b) { return predicted[a] < predicted[b]; });
+    const TIndex numTrue = std::min<TIndex>(n, std::max<TIndex>(1, std::ceil(m_evaluateFraction * n)));
+
+    MatrixType promising(x.rows(), numTrue);
+    for (TIndex k = 0; k < numTrue; ++k) promising.col(k) = x.col(order[k]);
+    TValues trueValues;
+    m_problem.batchValue(promising, trueValues);
+    m_trueEvaluations += numTrue;
+    m_savedEvaluations += n - numTrue;
+
+    Scalar worst = -std::numeric_limits<Scalar>::infinity();
+    for (TIndex k = 0; k < numTrue; ++k) {
+      values[order[k]] = trueValues[k];
+      worst = std::max(worst, trueValues[k]);
+      addSample(promising.col(k), trueValues[k]);
+    }
+    for (TIndex k = numTrue; k < n; ++k) {
+      values[order[k]] = std::max(predicted[order[k]], worst);
+    }
+  }
+
+  /**
+   * @brief surrogate prediction, only meaningful once enough samples have been collected
+   * @details uses the model fitted at the start of the last batchValue, later samples are not in it yet
+   */
+  Scalar predict(const TVector &x) const {
+    Scalar fx = m_tail[0] + m_tail.tail(x.rows()).dot(x);
+    for (TIndex i = 0; i < m_centers.cols(); ++i) {
+      const Scalar r = (x - m_centers.col(i)).norm();
+      fx += m_weights[i] * r * r * r;
+    }
+    return fx;
+  }
+
+ protected:
+  void addSample(const TVector &x, const Scalar fx) {
+    if (!std::isfinite(fx) || fx > m_ignoreAbove) return;
+    m_samples.push_back(x);
+    m_sampleValues.push_back(fx);
+    m_modelStale = true;
+    while (m_samples.size() > m_maxSamples) {
+      m_samples.pop_front();
+      m_sampleValues.pop_front();
+    }
+  }
+
+  // solves [Phi P; P^T 0] [w; c] = [f; 0]
+  void fit() {
+    m_modelValid = false;
+    m_modelStale = false;
+    if (m_samples.empty()) return;
+    const TIndex dim = m_samples.front().rows();
+    const TIndex n = m_samples.size();
+    if (n < 2 * (dim + 1)) return; // not enough to say anything useful yet
+
+    MatrixType A = MatrixType::Zero(n + dim + 1, n + dim + 1);
+    TValues b = TValues::Zero(n + dim + 1);
+    m_centers.resize(dim, n);
+    for (TIndex i = 0; i < n; ++i) {
+      m_centers.col(i) = m_samples[i];
+      for (TIndex j = 0; j < i; ++j) {
+        const Scalar r = (m_samples[i] - m_samples[j]).norm();
+        A(i, j) = A(j, i) = r * r * r;
+      }
+      A(i, n) = A(n, i) = 1;
+      A.block(i, n + 1, 1, dim) = m_samples[i].transpose();
+      A.block(n + 1, i, dim, 1) = m_samples[i];
+      b[i] = m_sampleValues[i];
+    }
+    const TValues solution = A.colPivHouseholderQr().solve(b);
+    if (!solution.allFinite()) return;
+    m_weights = solution.head(n);
+    m_tail = solution.tail(dim + 1);
+    m_modelValid = true;
+  }
+};
+
+} // end namespace cppoptlib
+
+#endif /* SURROGATEPROBLEM_H */